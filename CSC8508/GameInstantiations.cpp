@@ -20,23 +20,43 @@ GameObject* TutorialGame::AddNavMeshToWorld(const Vector3& position, Vector3 dim
 	GameObject* navMeshObject = new GameObject();
 	for (size_t i = 0; i < navigationMesh->GetSubMeshCount(); ++i)
 	{
-		if (navigationMesh->GetSubMesh(i)->count != 36)
+		std::vector<Vector3> vertices = GetVertices(navigationMesh, i);
+		if (vertices.empty())
 			continue;
 
-		std::vector<Vector3> vertices = GetVertices(navigationMesh, i);
+		// Every sub mesh collides as the hull around its vertices, only the cubes are drawn
+		bool isCube = navigationMesh->GetSubMesh(i)->count == 36;
 
 		Vector3 dimensions, localPosition;
 		Quaternion rotationMatrix;
-		CalculateCubeTransformations(vertices, localPosition, dimensions, rotationMatrix);
+		if (isCube) {
+			CalculateCubeTransformations(vertices, localPosition, dimensions, rotationMatrix);
+		}
+		else {
+			Vector3 minBound = vertices[0];
+			Vector3 maxBound = vertices[0];
+			for (const auto& vertex : vertices) {
+				minBound = Vector::Min(minBound, vertex);
+				maxBound = Vector::Max(maxBound, vertex);
+			}
+			localPosition = (minBound + maxBound) * 0.5f;
+			dimensions = (maxBound - minBound) * 0.5f;
+		}
+
+		Quaternion toLocal = rotationMatrix.Conjugate();
+		for (auto& vertex : vertices) {
+			vertex = toLocal * (vertex - localPosition);
+		}
 
 		GameObject* colliderObject = new GameObject();
-		OBBVolume* volume = new OBBVolume(dimensions);
+		ConvexHullVolume* volume = new ConvexHullVolume(vertices);
 
 		PhysicsComponent* phys = colliderObject->AddComponent<PhysicsComponent>();
 		BoundsComponent* bounds = colliderObject->AddComponent<BoundsComponent>((CollisionVolume*)volume, phys);
 
 		colliderObject->GetTransform().SetScale(dimensions * 2.0f).SetPosition(localPosition).SetOrientation(rotationMatrix);
-		colliderObject->SetRenderObject(new RenderObject(&colliderObject->GetTransform(), cubeMesh, basicTex, basicShader));
+		if (isCube)
+			colliderObject->SetRenderObject(new RenderObject(&colliderObject->GetTransform(), cubeMesh, basicTex, basicShader));
 
 		phys->SetPhysicsObject(new PhysicsObject(&colliderObject->GetTransform(), bounds->GetBoundingVolume()));
 		phys->GetPhysicsObject()->SetInverseMass(0);
@@ -362,6 +362,7 @@ void GameTechVulkanRenderer::RenderFrame() {
 
 void GameTechVulkanRenderer::UpdateObjectList() {
 	activeObjects.clear();
+	gameWorld.UpdateTransforms();
 
 	int objectCount = 0;
 
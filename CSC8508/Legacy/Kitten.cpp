@@ -22,7 +22,7 @@ Kitten::~Kitten() {
 
 void Kitten::ThrowSelf(Vector3 dir) 
 {
-    auto transform = this->GetTransform();
+    auto& transform = this->GetTransform();
     auto pos = transform.GetPosition();
     pos.y += 3.0f;   
     
@@ -30,7 +30,10 @@ void Kitten::ThrowSelf(Vector3 dir)
 
     this->GetTransform().SetPosition(pos);
     dir.y += 1.0f;
-   physicsComponent->GetPhysicsObject()->AddForce(dir * 80.0f);
+    //Only swept while in the air, see OnCollisionBegin
+    thrown = true;
+    physicsComponent->GetPhysicsObject()->UseContinuousCollision(true);
+    physicsComponent->GetPhysicsObject()->AddForce(dir * 80.0f);
 
 }
 
@@ -64,6 +64,10 @@ namespace NCL {
                 if (otherObject.GetTag() == Tags::CursorCast) {
                     selected = true;
                 }
+                else if (thrown) {
+                    thrown = false;
+                    physicsComponent->GetPhysicsObject()->UseContinuousCollision(false);
+                }
                 if (otherObject.GetTag() == Tags::Enemy) {
                     alive = false;
                     Quaternion rot = Quaternion::AxisAngleToQuaterion(Vector3(1, 0, 0), 90);
@@ -88,6 +92,7 @@ namespace NCL {
             bool alive = true;
             bool selected;
             bool yearnsForTheSwarm = false;
+            bool thrown = false;
 
 
             BehaviourAction* idle = new BehaviourAction("Idle",
@@ -34,7 +34,16 @@ NetworkedGame::NetworkedGame()	{
 
 	NetworkBase::Initialise();
 	timeToNextPacket  = 0.0f;
+	sendInterval      = 1.0f / 20.0f;
+	networkTime       = 0.0f;
+	latestSnapshotTime = 0.0f;
+	playbackTime      = 0.0f;
+	playoutDelay      = 0.1f;
+	maxExtrapolation  = 0.25f;
 	packetsToSnapshot = 0;
+	snapshotCounter   = 0;
+	lastReceivedSnapshot = -1;
+	receivedParts = 0;
 	playerStates = std::vector<int>();
 }
 
@@ -58,6 +67,7 @@ void NetworkedGame::StartAsClient(char a, char b, char c, char d)
 
 	thisClient->RegisterPacketHandler(Delta_State, this);
 	thisClient->RegisterPacketHandler(Full_State, this);
+	thisClient->RegisterPacketHandler(Snapshot_State, this);
 
 	thisClient->RegisterPacketHandler(Player_Connected, this);
 	thisClient->RegisterPacketHandler(Player_Disconnected, this);
@@ -67,6 +77,7 @@ void NetworkedGame::StartAsClient(char a, char b, char c, char d)
 
 void NetworkedGame::UpdateGame(float dt) 
 {
+	networkTime += dt;
 	timeToNextPacket -= dt;
 	if (timeToNextPacket < 0) {
 		if (thisServer) 
@@ -74,23 +85,17 @@ void NetworkedGame::UpdateGame(float dt)
 		else if (thisClient) 
 			UpdateAsClient(dt);
 
-		timeToNextPacket += 1.0f / 20.0f; //20hz server/client update
+		timeToNextPacket += sendInterval;
 	}
+	if (thisClient) 
+		UpdateRemoteObjects(dt);
+
 	TutorialGame::UpdateGame(dt);
 }
 
 void NetworkedGame::UpdateAsServer(float dt)
 {
-	packetsToSnapshot--;
-	if (packetsToSnapshot < 0) 
-	{
-		BroadcastSnapshot(false);
-		packetsToSnapshot = 5;
-	}
-	else {
-		BroadcastSnapshot(true);
-	}
-
+	BroadcastSnapshot();
 	thisServer->UpdateServer();
 }
 
@@ -129,9 +134,7 @@ void NetworkedGame::BroadcastOwnedObjects(bool deltaFrame) {
 		if (o->GetNetworkID() == 0) // id of server for now hard coded
 			continue;
 
-		GamePacket* newPacket = new GamePacket();
-		newPacket->type = Full_State;
-
+		GamePacket* newPacket = nullptr;
 		if (o->WritePacket(&newPacket, deltaFrame, 0)) //lastAcknowledgedState
 			thisClient->SendPacket(*newPacket);
 		delete newPacket;
@@ -139,38 +142,54 @@ void NetworkedGame::BroadcastOwnedObjects(bool deltaFrame) {
 }
 
 
-void NetworkedGame::BroadcastSnapshot(bool deltaFrame) 
+/*
+Every tick the world is recorded as a new snapshot, and each player is sent
+what has changed near them since the last snapshot they acknowledged, as much
+as fits in their budget. Players that haven't acknowledged anything yet, or
+whose last ack has fallen out of the buffer, get objects in full. Players
+without an object of their own on the server get sent from the whole world.
+*/
+void NetworkedGame::BroadcastSnapshot() 
 {
+	GatherNetworkObjects();
+
+	Snapshot& snapshot = snapshots.Add(++snapshotCounter);
+	snapshot.time = networkTime;
+	for (const auto& o : networkObjects) 
+		snapshot.Add(o.first, o.second->GetSnapshotState());
+	snapshot.Sort();
+
+	ClientPacket scorePacket;
+	scorePacket.score = score;
+	scorePacket.lastID = 0;
+
+	InterestManager& interest = thisServer->GetInterest();
+	interest.BuildGrid(snapshot);
+
 	for (const auto& player : thisServer->playerPeers)
 	{	
 		int playerID = player.first;
-		//int lastAcknowledgedState = playerStates[playerID];
-		std::vector<GameObject*>::const_iterator first, last;
-		world->GetObjectIterators(first, last);
 
-		for (auto i = first; i != last; ++i) 
+		Vector3 focus;
+		bool hasFocus = false;
+		auto serverPlayer = serverPlayers.find(playerID);
+		if (serverPlayer != serverPlayers.end() && serverPlayer->second) 
 		{
-			NetworkObject* o = (*i)->GetNetworkObject();
-
-			if (!o) 
-				continue;
+			focus = serverPlayer->second->GetTransform().GetPosition();
+			hasFocus = true;
+		}
 
-			GamePacket* newPacket = new GamePacket();
-			newPacket->type = Full_State;
+		std::vector<SnapshotPacket>& packets = peerPackets[playerID];
+		int parts = interest.WritePlayerSnapshot(playerID, hasFocus ? &focus : nullptr, snapshot, 
+			thisServer->GetLastAcknowledgedState(playerID), packets);
+		if (parts == 0) 
+			std::cout << __FUNCTION__ << " snapshot too large for player " << playerID << std::endl;
 
-			if (o->WritePacket(&newPacket, deltaFrame, 0)) //lastAcknowledgedState
-			{
-				thisServer->SendPacketToPeer(newPacket, playerID);
-				std::cout << "sending packet to peer" << std::endl;
-			}				
-			delete newPacket;
-		}
+		//A lost part is never resent - the player just won't ack, and gets a delta against something older
+		for (int i = 0; i < parts; ++i) 
+			thisServer->SendPacketToPeer(&packets[i], playerID, false);
 
-		ClientPacket* scorePacket = new ClientPacket();
-		scorePacket->score = score;
-		scorePacket->lastID = 0;
-		thisServer->SendPacketToPeer(scorePacket, playerID);
-		delete scorePacket;
+		thisServer->SendPacketToPeer(&scorePacket, playerID, false);
 	}
 }
 
@@ -198,6 +217,97 @@ void NetworkedGame::UpdateMinimumState()
 	}
 }
 
+void NetworkedGame::GatherNetworkObjects() 
+{
+	networkObjects.clear();
+
+	std::vector<GameObject*>::const_iterator first, last;
+	world->GetObjectIterators(first, last);
+	for (auto i = first; i != last; ++i)
+	{
+		NetworkObject* o = (*i)->GetNetworkObject();
+		if (o)
+			networkObjects[o->GetNetworkID()] = o;
+	}
+}
+
+/*
+Parts of a snapshot can turn up in any order, and are read in as they come.
+Only once every part is in is the snapshot kept, applied and acknowledged -
+if a part of a newer snapshot arrives first, the one in progress is dropped.
+Snapshots whose baseline has already been pushed out of the buffer are
+dropped too, and the server will fall back to an older baseline, or full
+states, until an ack gets through.
+*/
+void NetworkedGame::ReadSnapshot(const SnapshotPacket& packet) 
+{
+	if (packet.snapshotID <= lastReceivedSnapshot || packet.partCount == 0 || 
+		packet.partCount > SnapshotPacket::MaxParts || packet.partIndex >= packet.partCount) 
+		return;
+
+	if (packet.snapshotID != receivedSnapshot.id) 
+	{
+		if (packet.snapshotID < receivedSnapshot.id || 
+			!receivedSnapshot.BeginDelta(snapshots.Find(packet.baselineID), packet)) 
+			return;
+		receivedParts = 0;
+	}
+
+	uint32_t partBit = 1u << packet.partIndex;
+	if (receivedParts & partBit) 
+		return;
+
+	if (!receivedSnapshot.ReadDeltaPart(packet)) 
+	{
+		receivedSnapshot.Clear();
+		return;
+	}
+	receivedParts |= partBit;
+	if (receivedParts != (uint32_t)((1ull << packet.partCount) - 1)) 
+		return;
+
+	Snapshot& stored = snapshots.Add(packet.snapshotID);
+	stored.entries.swap(receivedSnapshot.entries);
+	stored.time = receivedSnapshot.time;
+	lastReceivedSnapshot = packet.snapshotID;
+	latestSnapshotTime = std::max(latestSnapshotTime, stored.time);
+
+	GatherNetworkObjects();
+	for (const SnapshotEntry& e : stored.entries) 
+	{
+		auto o = networkObjects.find(e.networkID);
+		if (o != networkObjects.end())
+			o->second->ReceiveSnapshotState(e.state, stored.time);
+	}
+	thisClient->AcknowledgeState(packet.snapshotID);
+}
+
+/*
+The playback clock runs at the client's own rate, and is eased towards sitting
+playoutDelay behind the newest snapshot, so it neither stalls nor jumps as
+snapshots arrive unevenly. After a long enough stall, it jumps straight there.
+*/
+void NetworkedGame::UpdateRemoteObjects(float dt) 
+{
+	if (lastReceivedSnapshot < 0) 
+		return;
+
+	const float maxClockError	= 0.5f;
+	const float correctionRate	= 2.0f; //Of the error, per second
+
+	float target = latestSnapshotTime - playoutDelay;
+	playbackTime += dt;
+	float error = target - playbackTime;
+	if (std::abs(error) > maxClockError) 
+		playbackTime = target;
+	else 
+		playbackTime += error * std::min(1.0f, dt * correctionRate);
+
+	GatherNetworkObjects();
+	for (const auto& o : networkObjects) 
+		o.second->UpdateInterpolation(playbackTime, maxExtrapolation);
+}
+
 void NetworkedGame::SpawnPlayer() 
 {
 	auto play = TutorialGame::AddPlayerToWorld(Vector3(90, 22, -50));
@@ -215,6 +325,13 @@ void NetworkedGame::StartLevel()
 
 void NetworkedGame::ReceivePacket(int type, GamePacket* payload, int source)
 {
+	if (type == Snapshot_State) 
+	{
+		if (thisClient)
+			ReadSnapshot(*(SnapshotPacket*)payload);
+		return;
+	}
+
 	std::vector<GameObject*>::const_iterator first, last;
 	world->GetObjectIterators(first, last);
 	for (auto i = first; i != last; ++i)
@@ -2,6 +2,7 @@
 #include "TutorialGame.h"
 #include "NetworkBase.h"
 #include "NetworkObject.h"
+#include "NetworkSnapshot.h"
 
 namespace NCL {
 	namespace CSC8508 {
@@ -21,6 +22,20 @@ namespace NCL {
 
 			void SpawnPlayer();
 
+			void SetSendRate(float hz) {
+				sendInterval = 1.0f / hz;
+			}
+
+			//How far behind the newest snapshot remote objects are shown, so there's a state to move towards
+			void SetPlayoutDelay(float seconds) {
+				playoutDelay = seconds;
+			}
+
+			//How long remote objects carry on at their last velocity once snapshots stop arriving
+			void SetMaxExtrapolation(float seconds) {
+				maxExtrapolation = seconds;
+			}
+
 			void StartLevel();
 
 			void ReceivePacket(int type, GamePacket* payload, int source) override;
@@ -37,14 +52,33 @@ namespace NCL {
 			void StartOfflineCallBack();
 
 
-			void BroadcastSnapshot(bool deltaFrame);
+			void BroadcastSnapshot();
 			void BroadcastOwnedObjects(bool deltaFrame);
 			void UpdateMinimumState();
 			std::map<int, int> stateIDs;
 
+			void ReadSnapshot(const SnapshotPacket& packet);
+			void GatherNetworkObjects();
+			void UpdateRemoteObjects(float dt);
+
+			SnapshotBuffer	snapshots;
+			Snapshot		receivedSnapshot; //Being put back together from its parts
+			uint32_t		receivedParts;
+			int				snapshotCounter;
+			int				lastReceivedSnapshot;
+			std::unordered_map<int, NetworkObject*> networkObjects;
+			std::unordered_map<int, std::vector<SnapshotPacket>> peerPackets; //Reused every tick
+
 			GameServer* thisServer;
 			GameClient* thisClient;
 			float timeToNextPacket;
+			float sendInterval;
+
+			float networkTime;			//The server's clock, on the server
+			float latestSnapshotTime;	//The server's clock, as of the newest snapshot in
+			float playbackTime;			//The server time remote objects are being shown at
+			float playoutDelay;
+			float maxExtrapolation;
 			int packetsToSnapshot;
 
 			std::map<int, GameObject*> serverPlayers;
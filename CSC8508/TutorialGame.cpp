@@ -27,6 +27,12 @@ TutorialGame::TutorialGame() : controller(*Window::GetWindow()->GetKeyboard(), *
 
 	physics = new PhysicsSystem(*world);
 
+	world->GetScheduler().AddSystem(UpdatePhases::PhysicsStep, [this](float dt) {
+		physics->Update(dt);
+		physics->DispatchCollisionEvents();
+	});
+	world->GetScheduler().AddSystem(UpdatePhases::LateUpdate, [this](float dt) { UpdateCamera(dt); });
+
 	forceMagnitude	= 10.0f;
 	useGravity		= false;
 	inSelectionMode = false;
@@ -45,7 +51,6 @@ TutorialGame::TutorialGame() : controller(*Window::GetWindow()->GetKeyboard(), *
 	
 	physics->UseGravity(true);
 	world->UpdateWorld(0.1f);
-	physics->Update(0.1f);
 }
 
 void TutorialGame::SetPause(bool state) {
@@ -115,7 +120,7 @@ void TutorialGame::UpdateObjectSelectMode(float dt) {
 		rayPos = selectionObject->GetGameObject().GetTransform().GetPosition();
 
 		Ray r = Ray(rayPos, rayDir);
-		bool hit = world->Raycast(r, closestCollision, true, selectionObject, new std::vector<Layers::LayerID>({ Layers::LayerID::Player,  Layers::LayerID::Enemy }));
+		bool hit = world->Raycast(r, closestCollision, true, selectionObject, Layers::ToMask(Layers::LayerID::Player) | Layers::ToMask(Layers::LayerID::Enemy));
 
 		if (hit)
 		{
@@ -165,13 +170,11 @@ void TutorialGame::UpdateGame(float dt)
 		return;
 
 	UpdateDrawScreen(dt);
-	world->UpdateWorld(dt);
 
 	Window::GetWindow()->ShowOSPointer(true);
 	//Window::GetWindow()->LockMouseToWindow(true);
 
-	physics->Update(dt);
-	UpdateCamera(dt);
+	world->UpdateWorld(dt);
 }
 
 void TutorialGame::LockedObjectMovement() 
@@ -3,7 +3,7 @@
 
 namespace NCL {
 	using namespace NCL::Maths;
-	class AABBVolume : CollisionVolume
+	class AABBVolume : public CollisionVolume
 	{
 	public:
 		AABBVolume(const Vector3& halfDims) {
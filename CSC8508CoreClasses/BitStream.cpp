@@ -0,0 +1,233 @@
+#include "BitStream.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace NCL;
+using namespace CSC8508;
+
+namespace {
+	const float SmallestThreeLimit = 0.70710678f; //1 / sqrt(2)
+
+	uint32_t LowBits(int bits) {
+		return bits >= 32 ? 0xFFFFFFFF : (1u << bits) - 1;
+	}
+}
+
+uint32_t NCL::CSC8508::QuantiseFloat(float value, float min, float max, int bits) {
+	float t = (std::clamp(value, min, max) - min) / (max - min);
+	return (uint32_t)std::lround(t * (float)LowBits(bits));
+}
+
+float NCL::CSC8508::DequantiseFloat(uint32_t value, float min, float max, int bits) {
+	return min + (max - min) * ((float)value / (float)LowBits(bits));
+}
+
+SmallestThree SmallestThree::Compress(const Quaternion& q, int bits) {
+	float c[4] = { q.x, q.y, q.z, q.w };
+	float length = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+
+	SmallestThree s;
+	for (int i = 0; i < 4; ++i) {
+		if (std::abs(c[i]) > std::abs(c[s.largest])) {
+			s.largest = (uint8_t)i;
+		}
+	}
+	float sign = (c[s.largest] < 0.0f ? -1.0f : 1.0f) / (length > 0.0f ? length : 1.0f);
+	for (int i = 0, v = 0; i < 4; ++i) {
+		if (i != s.largest) {
+			s.values[v++] = (uint16_t)QuantiseFloat(c[i] * sign, -SmallestThreeLimit, SmallestThreeLimit, bits);
+		}
+	}
+	return s;
+}
+
+Quaternion SmallestThree::Decompress(int bits) const {
+	float c[4];
+	float sum = 0.0f;
+	for (int i = 0, v = 0; i < 4; ++i) {
+		if (i != largest) {
+			c[i] = DequantiseFloat(values[v++], -SmallestThreeLimit, SmallestThreeLimit, bits);
+			sum += c[i] * c[i];
+		}
+	}
+	c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+	Quaternion q(c[0], c[1], c[2], c[3]);
+	q.Normalise();
+	return q;
+}
+
+BitWriter::BitWriter(char* data, int capacity) {
+	this->data		= data;
+	capacityBits	= capacity * 8;
+	bitPosition		= 0;
+	overflowed		= false;
+}
+
+void BitWriter::WriteBits(uint32_t value, int bits) {
+	if (bitPosition + bits > capacityBits) {
+		overflowed = true;
+		return;
+	}
+	value &= LowBits(bits);
+	while (bits > 0) {
+		int byte	= bitPosition >> 3;
+		int offset	= bitPosition & 7;
+		int count	= std::min(8 - offset, bits);
+		if (offset == 0) {
+			data[byte] = 0;
+		}
+		data[byte] |= (char)((value & LowBits(count)) << offset);
+		value		>>= count;
+		bits		-= count;
+		bitPosition += count;
+	}
+}
+
+void BitWriter::WriteVarInt(uint32_t value, int groupBits) {
+	while (value > LowBits(groupBits)) {
+		WriteBits(value, groupBits);
+		WriteBool(true);
+		value >>= groupBits;
+	}
+	WriteBits(value, groupBits);
+	WriteBool(false);
+}
+
+void BitWriter::WriteBoundedInt(int32_t value, int32_t min, int32_t max) {
+	value = std::clamp(value, min, max);
+	WriteBits((uint32_t)((int64_t)value - min), BitsForRange((uint32_t)((int64_t)max - min)));
+}
+
+void BitWriter::WriteFloat(float value, float min, float max, int bits) {
+	WriteBits(QuantiseFloat(value, min, max, bits), bits);
+}
+
+void BitWriter::WriteVector3(const Vector3& value, float min, float max, int bits) {
+	for (int i = 0; i < 3; ++i) {
+		WriteFloat(value[i], min, max, bits);
+	}
+}
+
+void BitWriter::WriteQuaternion(const Quaternion& value, int bits) {
+	WriteSmallestThree(SmallestThree::Compress(value, bits), bits);
+}
+
+void BitWriter::WriteSmallestThree(const SmallestThree& value, int bits) {
+	WriteBits(value.largest, 2);
+	for (int i = 0; i < 3; ++i) {
+		WriteBits(value.values[i], bits);
+	}
+}
+
+//Bits past the new end in a part written byte are cleared, as later writes only OR into it
+void BitWriter::Rewind(int toBit) {
+	bitPosition = std::clamp(toBit, 0, bitPosition);
+	if (bitPosition & 7) {
+		data[bitPosition >> 3] &= (char)LowBits(bitPosition & 7);
+	}
+	overflowed = false;
+}
+
+BitReader::BitReader(const char* data, int size) {
+	this->data	= data;
+	sizeBits	= size * 8;
+	bitPosition = 0;
+}
+
+bool BitReader::ReadBits(uint32_t& value, int bits) {
+	if (bitPosition + bits > sizeBits) {
+		return false;
+	}
+	value = 0;
+	int shift = 0;
+	while (bits > 0) {
+		int offset	= bitPosition & 7;
+		int count	= std::min(8 - offset, bits);
+		uint32_t b	= ((uint8_t)data[bitPosition >> 3] >> offset) & LowBits(count);
+		value		|= b << shift;
+		shift		+= count;
+		bits		-= count;
+		bitPosition += count;
+	}
+	return true;
+}
+
+bool BitReader::ReadBool(bool& value) {
+	uint32_t b;
+	if (!ReadBits(b, 1)) {
+		return false;
+	}
+	value = b != 0;
+	return true;
+}
+
+bool BitReader::ReadVarInt(uint32_t& value, int groupBits) {
+	value = 0;
+	for (int shift = 0; shift < 32; shift += groupBits) {
+		uint32_t group;
+		bool more;
+		if (!ReadBits(group, groupBits) || !ReadBool(more)) {
+			return false;
+		}
+		value |= group << shift;
+		if (!more) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool BitReader::ReadBoundedInt(int32_t& value, int32_t min, int32_t max) {
+	uint32_t bits;
+	if (!ReadBits(bits, BitsForRange((uint32_t)((int64_t)max - min)))) {
+		return false;
+	}
+	int64_t v = (int64_t)min + bits;
+	if (v > max) {
+		return false;
+	}
+	value = (int32_t)v;
+	return true;
+}
+
+bool BitReader::ReadFloat(float& value, float min, float max, int bits) {
+	uint32_t q;
+	if (!ReadBits(q, bits)) {
+		return false;
+	}
+	value = DequantiseFloat(q, min, max, bits);
+	return true;
+}
+
+bool BitReader::ReadVector3(Vector3& value, float min, float max, int bits) {
+	for (int i = 0; i < 3; ++i) {
+		if (!ReadFloat(value[i], min, max, bits)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool BitReader::ReadQuaternion(Quaternion& value, int bits) {
+	SmallestThree s;
+	if (!ReadSmallestThree(s, bits)) {
+		return false;
+	}
+	value = s.Decompress(bits);
+	return true;
+}
+
+bool BitReader::ReadSmallestThree(SmallestThree& value, int bits) {
+	uint32_t v;
+	if (!ReadBits(v, 2)) {
+		return false;
+	}
+	value.largest = (uint8_t)v;
+	for (int i = 0; i < 3; ++i) {
+		if (!ReadBits(v, bits)) {
+			return false;
+		}
+		value.values[i] = (uint16_t)v;
+	}
+	return true;
+}
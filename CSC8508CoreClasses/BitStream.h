@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8508 {
+		//How many bits it takes to hold every value from 0 to range
+		constexpr int BitsForRange(uint32_t range) {
+			int bits = 0;
+			while (range > 0) {
+				bits++;
+				range >>= 1;
+			}
+			return bits;
+		}
+
+		//Maps a float clamped to min..max onto the whole numbers that fit in the given bits
+		uint32_t	QuantiseFloat(float value, float min, float max, int bits);
+		float		DequantiseFloat(uint32_t value, float min, float max, int bits);
+
+		/*
+		A unit quaternion with its largest component left out. q and -q are the
+		same rotation, so the largest can always be made positive and rebuilt
+		from the other three, which can then be no bigger than 1/sqrt(2) either
+		way, and so quantise well into a few bits each.
+		*/
+		struct SmallestThree {
+			uint8_t		largest		= 3;
+			uint16_t	values[3]	= { 0, 0, 0 };
+
+			static SmallestThree Compress(const Quaternion& q, int bits);
+			Quaternion Decompress(int bits) const;
+
+			bool operator==(const SmallestThree& other) const {
+				return largest == other.largest && values[0] == other.values[0] &&
+					values[1] == other.values[1] && values[2] == other.values[2];
+			}
+			bool operator!=(const SmallestThree& other) const {
+				return !(*this == other);
+			}
+		};
+
+		/*
+		Packs values into a buffer using only as many bits as each needs, lowest
+		bits first, a byte at a time, so the result reads back the same whatever
+		the machine or compiler. Writing past the end of the buffer sets a flag,
+		rather than writing anything, and Rewind can go back to an earlier point
+		to try again.
+		*/
+		class BitWriter {
+		public:
+			BitWriter(char* data, int capacity);
+
+			void WriteBits(uint32_t value, int bits);
+			void WriteBool(bool value) {
+				WriteBits(value ? 1 : 0, 1);
+			}
+
+			//Groups of groupBits, each followed by a bit saying if another group follows
+			void WriteVarInt(uint32_t value, int groupBits = 7);
+			void WriteBoundedInt(int32_t value, int32_t min, int32_t max);
+
+			void WriteFloat(float value, float min, float max, int bits);
+			void WriteVector3(const Vector3& value, float min, float max, int bits);
+			void WriteQuaternion(const Quaternion& value, int bits);
+			void WriteSmallestThree(const SmallestThree& value, int bits);
+
+			int GetBitPosition() const {
+				return bitPosition;
+			}
+			void Rewind(int toBit);
+
+			int GetBytesWritten() const {
+				return (bitPosition + 7) / 8;
+			}
+
+			bool HasOverflowed() const {
+				return overflowed;
+			}
+
+		protected:
+			char*	data;
+			int		capacityBits;
+			int		bitPosition;
+			bool	overflowed;
+		};
+
+		//Reads back what a BitWriter wrote. Every read returns false once the data runs out.
+		class BitReader {
+		public:
+			BitReader(const char* data, int size);
+
+			bool ReadBits(uint32_t& value, int bits);
+			bool ReadBool(bool& value);
+
+			bool ReadVarInt(uint32_t& value, int groupBits = 7);
+			bool ReadBoundedInt(int32_t& value, int32_t min, int32_t max);
+
+			bool ReadFloat(float& value, float min, float max, int bits);
+			bool ReadVector3(Vector3& value, float min, float max, int bits);
+			bool ReadQuaternion(Quaternion& value, int bits);
+			bool ReadSmallestThree(SmallestThree& value, int bits);
+
+		protected:
+			const char* data;
+			int			sizeBits;
+			int			bitPosition;
+		};
+	}
+}
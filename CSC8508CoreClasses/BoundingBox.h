@@ -0,0 +1,71 @@
+#pragma once
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8508 {
+		struct BoundingBox {
+			Vector3 min;
+			Vector3 max;
+
+			BoundingBox() {}
+
+			BoundingBox(const Vector3& min, const Vector3& max) {
+				this->min = min;
+				this->max = max;
+			}
+
+			static BoundingBox FromCentre(const Vector3& centre, const Vector3& halfSize) {
+				return BoundingBox(centre - halfSize, centre + halfSize);
+			}
+
+			static BoundingBox Combine(const BoundingBox& a, const BoundingBox& b) {
+				return BoundingBox(Vector::Min(a.min, b.min), Vector::Max(a.max, b.max));
+			}
+
+			bool Contains(const BoundingBox& other) const {
+				return	min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+						other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+			}
+
+			bool Overlaps(const BoundingBox& other) const {
+				return	min.x <= other.max.x && other.min.x <= max.x &&
+						min.y <= other.max.y && other.min.y <= max.y &&
+						min.z <= other.max.z && other.min.z <= max.z;
+			}
+
+			/*
+			Slab test against a ray, given one over its direction. Only hits
+			closer than maxDistance count, and a ray starting inside the box
+			always hits it.
+			*/
+			bool RayIntersects(const Vector3& origin, const Vector3& invDirection, float maxDistance) const {
+				float tMin = 0.0f;
+				float tMax = maxDistance;
+				for (int i = 0; i < 3; ++i) {
+					float t1 = (min[i] - origin[i]) * invDirection[i];
+					float t2 = (max[i] - origin[i]) * invDirection[i];
+					tMin = std::max(tMin, std::min(t1, t2));
+					tMax = std::min(tMax, std::max(t1, t2));
+					if (tMin > tMax) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			//Surface area heuristic cost - half the true area, which is all the tree needs
+			float GetCost() const {
+				Vector3 d = max - min;
+				return (d.x * d.y) + (d.y * d.z) + (d.z * d.x);
+			}
+
+			Vector3 GetCentre() const {
+				return (min + max) * 0.5f;
+			}
+
+			Vector3 GetHalfSize() const {
+				return (max - min) * 0.5f;
+			}
+		};
+	}
+}
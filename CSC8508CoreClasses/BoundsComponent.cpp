@@ -13,7 +13,6 @@ using namespace NCL::CSC8508;
 BoundsComponent::BoundsComponent(GameObject& gameObject, CollisionVolume* collisionVolume, PhysicsComponent* physicsComponent) : IComponent(gameObject) {
 	this->boundingVolume = collisionVolume;
 	this->physicsComponent = physicsComponent;
-	vector<Layers::LayerID> ignoreLayers = vector<Layers::LayerID>();
 }
 
 BoundsComponent::~BoundsComponent() {
@@ -40,9 +39,25 @@ void BoundsComponent::UpdateBroadphaseAABB() {
 		broadphaseAABB = Vector3(r, r, r);
 	}
 	else if (static_cast<int>(boundingVolume->type) == static_cast<int>(VolumeType::OBB)) {
-		/*Matrix3 mat = Quaternion::RotationMatrix<Matrix3>(transform.GetOrientation());
+		Matrix3 mat = Quaternion::RotationMatrix<Matrix3>(GetGameObject().GetTransform().GetOrientation());
 		mat = Matrix::Absolute(mat);
 		Vector3 halfSizes = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
-		broadphaseAABB = mat * halfSizes;*/
+		broadphaseAABB = mat * halfSizes;
 	}
+	else if (static_cast<int>(boundingVolume->type) == static_cast<int>(VolumeType::Capsule)) {
+		const CapsuleVolume& capsule = (CapsuleVolume&)*boundingVolume;
+		Vector3 axis = GetGameObject().GetTransform().GetOrientation() * Vector3(0, capsule.GetHalfHeight(), 0);
+		float r = capsule.GetRadius();
+		broadphaseAABB = Vector3(std::abs(axis.x) + r, std::abs(axis.y) + r, std::abs(axis.z) + r);
+	}
+	else if (static_cast<int>(boundingVolume->type) == static_cast<int>(VolumeType::ConvexHull)) {
+		Matrix3 mat = Quaternion::RotationMatrix<Matrix3>(GetGameObject().GetTransform().GetOrientation());
+		mat = Matrix::Absolute(mat);
+		Vector3 halfSizes = ((ConvexHullVolume&)*boundingVolume).GetHalfDimensions();
+		broadphaseAABB = mat * halfSizes;
+	}
+}
+
+BoundingBox BoundsComponent::GetWorldBounds() {
+	return BoundingBox::FromCentre(GetGameObject().GetTransform().GetPosition(), broadphaseAABB);
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "IComponent.h"
 #include "CollisionVolume.h"
 #include "PhysicsComponent.h"
+#include "BoundingBox.h"
 #include "GameObject.h" // Just for layers namespace
 
 using std::vector;
@@ -40,14 +41,50 @@ namespace NCL::CSC8508
 
 		void UpdateBroadphaseAABB();
 
-		void AddToIgnoredLayers(Layers::LayerID layerID) { ignoreLayers.push_back(layerID); }
-		const std::vector<Layers::LayerID>& GetIgnoredLayers() const { return ignoreLayers; }
+		/**
+		* Function gets the world space box around the volume, as of the last UpdateBroadphaseAABB.
+		* @return the world space bounding box
+		*/
+		BoundingBox GetWorldBounds();
+
+		int GetBroadphaseProxy() const { return broadphaseProxy; }
+		void SetBroadphaseProxy(int proxy) { broadphaseProxy = proxy; }
+
+		int GetSweepProxy() const { return sweepProxy; }
+		void SetSweepProxy(int proxy) { sweepProxy = proxy; }
+
+		/**
+		* Objects on ignored layers still report collisions with this one, but aren't pushed apart from it.
+		*/
+		void AddToIgnoredLayers(Layers::LayerID layerID) { ignoredLayers |= Layers::ToMask(layerID); }
+		Layers::LayerMask GetIgnoredLayers() const { return ignoredLayers; }
+
+		/**
+		* Function sets which categories this volume is in, and which categories it can collide with.
+		* A pair is only tested if each is in a category the other collides with.
+		* @param category bits for the categories this volume belongs to
+		* @param mask bits for the categories this volume collides with
+		*/
+		void SetCollisionFilter(uint32_t category, uint32_t mask) {
+			collisionCategory	= category;
+			collisionMask		= mask;
+		}
+		uint32_t GetCollisionCategory() const { return collisionCategory; }
+		uint32_t GetCollisionMask() const { return collisionMask; }
+
+		bool PassesCollisionFilter(const BoundsComponent& other) const {
+			return (collisionCategory & other.collisionMask) && (other.collisionCategory & collisionMask);
+		}
 
 	protected:
 		CollisionVolume* boundingVolume;
 		PhysicsComponent* physicsComponent;
 		Vector3 broadphaseAABB;
-		vector<Layers::LayerID> ignoreLayers;
+		int broadphaseProxy = -1;
+		int sweepProxy = -1;
+		Layers::LayerMask ignoredLayers = 0;
+		uint32_t collisionCategory = 1;
+		uint32_t collisionMask = 0xFFFFFFFF;
 	};
 }
 
@@ -41,6 +41,7 @@ bool CollisionDetection::RayIntersection(const Ray& r, BoundsComponent& object,
 		case VolumeType::OBB:		hasCollided = RayOBBIntersection(r, worldTransform, (const OBBVolume&)*volume	, collision); break;
 		case VolumeType::Sphere:	hasCollided = RaySphereIntersection(r, worldTransform, (const SphereVolume&)*volume	, collision); break;
 		case VolumeType::Capsule:	hasCollided = RayCapsuleIntersection(r, worldTransform, (const CapsuleVolume&)*volume, collision); break;
+		case VolumeType::ConvexHull:hasCollided = RayConvexHullIntersection(r, worldTransform, (const ConvexHullVolume&)*volume, collision); break;
 	}
 
 	return hasCollided;
@@ -135,7 +136,31 @@ bool CollisionDetection::RaySphereIntersection(const Ray& r, const Transform& wo
 
 
 bool CollisionDetection::RayCapsuleIntersection(const Ray& r, const Transform& worldTransform, const CapsuleVolume& volume, RayCollision& collision) {
-	return false;
+	return RayConvexIntersection(r, worldTransform, (const CollisionVolume&)volume, volume.GetHalfHeight() + volume.GetRadius(), collision);
+}
+
+bool CollisionDetection::RayConvexHullIntersection(const Ray& r, const Transform& worldTransform, const ConvexHullVolume& volume, RayCollision& collision) {
+	return RayConvexIntersection(r, worldTransform, (const CollisionVolume&)volume, Vector::Length(volume.GetHalfDimensions()), collision);
+}
+
+/*
+Treats the ray as a point swept along it, out as far as the far side of a
+sphere bounding the volume, so anything with a closest point can be hit.
+*/
+bool CollisionDetection::RayConvexIntersection(const Ray& r, const Transform& worldTransform, const CollisionVolume& volume, float boundingRadius, RayCollision& collision) {
+	Vector3 toVolume	= worldTransform.GetPosition() - r.GetPosition();
+	float reach			= Vector::Dot(toVolume, r.GetDirection()) + boundingRadius;
+	if (reach < 0.0f) {
+		return false;
+	}
+	float	toi;
+	Vector3 normal;
+	if (!SphereTimeOfImpact(r.GetPosition(), r.GetDirection() * reach, 0.0f, volume, worldTransform, toi, normal)) {
+		return false;
+	}
+	collision.rayDistance	= reach * toi;
+	collision.collidedAt	= r.GetPosition() + (r.GetDirection() * collision.rayDistance);
+	return true;
 }
 
 bool CollisionDetection::ObjectIntersection(BoundsComponent* a, BoundsComponent* b, CollisionInfo& collisionInfo) {
@@ -162,11 +187,6 @@ bool CollisionDetection::ObjectIntersection(BoundsComponent* a, BoundsComponent*
 	if (pairType == VolumeType::Sphere) {
 		return SphereIntersection((SphereVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
-	//Two OBBs
-	if (pairType == VolumeType::OBB) {
-		return OBBIntersection((OBBVolume&)*volA, transformA, (OBBVolume&)*volB, transformB, collisionInfo);
-	}
-	//Two Capsules
 
 	//AABB vs Sphere pairs
 	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
@@ -198,16 +218,8 @@ bool CollisionDetection::ObjectIntersection(BoundsComponent* a, BoundsComponent*
 		return SphereCapsuleIntersection((CapsuleVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
-	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::OBB) {		
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return OBBCapsuleIntersection((CapsuleVolume&)*volA, transformA, (OBBVolume&)*volB, transformB, collisionInfo);
-	}
-	if (volB->type == VolumeType::Capsule && volA->type == VolumeType::OBB) {
-		return OBBCapsuleIntersection((CapsuleVolume&)*volB, transformB, (OBBVolume&)*volA, transformA, collisionInfo);
-	}
-
-	return false;
+	//Everything else - boxes against boxes or capsules, capsule pairs, and convex hulls
+	return GJKIntersection(*volA, transformA, *volB, transformB, collisionInfo);
 }
 
 bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, const Vector3& halfSizeA, const Vector3& halfSizeB) {
@@ -617,6 +629,592 @@ bool CollisionDetection::SphereCapsuleIntersection(
 	return false;
 }
 
+/*
+General convex collisions, for every pair without a dedicated test. Volumes
+are only described by their support function - their furthest point in a
+given direction - and GJK walks a simplex over the Minkowski difference of the
+two volumes to find how close it gets to the origin. Spheres and capsules are
+treated as a point or line with a radius around it, so GJK finds their exact
+closest points when only the radii overlap, and EPA is only needed to find how
+deep the volumes are when their cores overlap too.
+*/
+namespace {
+	struct SupportPoint {
+		Vector3 w;	//Point on the Minkowski difference, a - b
+		Vector3 a;
+		Vector3 b;
+	};
+
+	struct Simplex {
+		SupportPoint	points[4];
+		float			weights[4];
+		int				count = 0;
+	};
+
+	struct PolytopeFace {
+		int		a, b, c;
+		Vector3 normal;
+		float	distance;
+	};
+}
+
+static bool IsSupportMapped(const CollisionVolume& volume) {
+	switch (volume.type) {
+		case VolumeType::AABB:
+		case VolumeType::OBB:
+		case VolumeType::Sphere:
+		case VolumeType::Capsule:
+		case VolumeType::ConvexHull:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static float GetCoreRadius(const CollisionVolume& volume) {
+	if (volume.type == VolumeType::Sphere) {
+		return ((const SphereVolume&)volume).GetRadius();
+	}
+	if (volume.type == VolumeType::Capsule) {
+		return ((const CapsuleVolume&)volume).GetRadius();
+	}
+	return 0.0f;
+}
+
+static Vector3 GetCoreSupport(const CollisionVolume& volume, const Transform& worldTransform, const Vector3& dir) {
+	Vector3		position	= worldTransform.GetPosition();
+	Quaternion	orientation = worldTransform.GetOrientation();
+
+	switch (volume.type) {
+		case VolumeType::AABB: {
+			Vector3 halfSize = ((const AABBVolume&)volume).GetHalfDimensions();
+			return position + Vector3(dir.x < 0.0f ? -halfSize.x : halfSize.x, dir.y < 0.0f ? -halfSize.y : halfSize.y, dir.z < 0.0f ? -halfSize.z : halfSize.z);
+		}
+		case VolumeType::OBB: {
+			Vector3 halfSize	= ((const OBBVolume&)volume).GetHalfDimensions();
+			Vector3 localDir	= orientation.Conjugate() * dir;
+			return position + orientation * Vector3(localDir.x < 0.0f ? -halfSize.x : halfSize.x, localDir.y < 0.0f ? -halfSize.y : halfSize.y, localDir.z < 0.0f ? -halfSize.z : halfSize.z);
+		}
+		case VolumeType::Capsule: {
+			Vector3 axis = orientation * Vector3(0, ((const CapsuleVolume&)volume).GetHalfHeight(), 0);
+			return Vector::Dot(axis, dir) < 0.0f ? position - axis : position + axis;
+		}
+		case VolumeType::ConvexHull: {
+			return position + orientation * ((const ConvexHullVolume&)volume).GetSupport(orientation.Conjugate() * dir);
+		}
+		default:
+			return position;
+	}
+}
+
+static SupportPoint GetMinkowskiSupport(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, const Vector3& dir, bool withRadius) {
+	SupportPoint p;
+	p.a = GetCoreSupport(volumeA, worldTransformA, dir);
+	p.b = GetCoreSupport(volumeB, worldTransformB, -dir);
+	if (withRadius) {
+		float length = Vector::Length(dir);
+		if (length > 0.0f) {
+			p.a += dir * (GetCoreRadius(volumeA) / length);
+			p.b -= dir * (GetCoreRadius(volumeB) / length);
+		}
+	}
+	p.w = p.a - p.b;
+	return p;
+}
+
+static void KeepSimplexPoints(Simplex& s, int i0, float w0, int i1 = -1, float w1 = 0.0f, int i2 = -1, float w2 = 0.0f) {
+	SupportPoint p[3] = { s.points[i0], i1 >= 0 ? s.points[i1] : SupportPoint(), i2 >= 0 ? s.points[i2] : SupportPoint() };
+	s.points[0] = p[0]; s.weights[0] = w0; s.count = 1;
+	if (i1 >= 0) { s.points[1] = p[1]; s.weights[1] = w1; s.count = 2; }
+	if (i2 >= 0) { s.points[2] = p[2]; s.weights[2] = w2; s.count = 3; }
+}
+
+//Reduces the triangle i0, i1, i2 down to the feature closest to the origin
+static void SolveTriangle(Simplex& s, int i0, int i1, int i2) {
+	Vector3 a = s.points[i0].w;
+	Vector3 b = s.points[i1].w;
+	Vector3 c = s.points[i2].w;
+
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+
+	float d1 = -Vector::Dot(ab, a);
+	float d2 = -Vector::Dot(ac, a);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		KeepSimplexPoints(s, i0, 1.0f);
+		return;
+	}
+	float d3 = -Vector::Dot(ab, b);
+	float d4 = -Vector::Dot(ac, b);
+	if (d3 >= 0.0f && d4 <= d3) {
+		KeepSimplexPoints(s, i1, 1.0f);
+		return;
+	}
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		float v = d1 / (d1 - d3);
+		KeepSimplexPoints(s, i0, 1.0f - v, i1, v);
+		return;
+	}
+	float d5 = -Vector::Dot(ab, c);
+	float d6 = -Vector::Dot(ac, c);
+	if (d6 >= 0.0f && d5 <= d6) {
+		KeepSimplexPoints(s, i2, 1.0f);
+		return;
+	}
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		float w = d2 / (d2 - d6);
+		KeepSimplexPoints(s, i0, 1.0f - w, i2, w);
+		return;
+	}
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		KeepSimplexPoints(s, i1, 1.0f - w, i2, w);
+		return;
+	}
+	float denom = 1.0f / (va + vb + vc);
+	float v = vb * denom;
+	float w = vc * denom;
+	KeepSimplexPoints(s, i0, 1.0f - v - w, i1, v, i2, w);
+}
+
+/*
+Reduces the simplex to the smallest set of points whose closest point to the
+origin is the same as the whole simplex's, and works out that closest point.
+Returns false if the simplex is a tetrahedron with the origin inside it.
+*/
+static bool SolveSimplex(Simplex& s, Vector3& closest) {
+	if (s.count == 1) {
+		s.weights[0] = 1.0f;
+	}
+	else if (s.count == 2) {
+		Vector3 a	= s.points[0].w;
+		Vector3 ab	= s.points[1].w - a;
+		float t		= -Vector::Dot(a, ab) / std::max(Vector::Dot(ab, ab), 1e-12f);
+		if (t <= 0.0f) {
+			KeepSimplexPoints(s, 0, 1.0f);
+		}
+		else if (t >= 1.0f) {
+			KeepSimplexPoints(s, 1, 1.0f);
+		}
+		else {
+			KeepSimplexPoints(s, 0, 1.0f - t, 1, t);
+		}
+	}
+	else if (s.count == 3) {
+		SolveTriangle(s, 0, 1, 2);
+	}
+	else {
+		//Each face, along with the point opposite it
+		static const int faces[4][4] = { {0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0} };
+
+		Vector3 a = s.points[0].w;
+		float volume	= Vector::Dot(s.points[3].w - a, Vector::Cross(s.points[1].w - a, s.points[2].w - a));
+		bool flat		= std::abs(volume) < 1e-9f;
+
+		Simplex best;
+		float bestDistance	= FLT_MAX;
+		bool outsideAny		= false;
+		for (int i = 0; i < 4; ++i) {
+			Vector3 p0 = s.points[faces[i][0]].w;
+			Vector3 n = Vector::Cross(s.points[faces[i][1]].w - p0, s.points[faces[i][2]].w - p0);
+			float originSide	= -Vector::Dot(p0, n);
+			float oppositeSide	= Vector::Dot(s.points[faces[i][3]].w - p0, n);
+			if (!flat && originSide * oppositeSide >= 0.0f) {
+				continue;
+			}
+			outsideAny = true;
+			Simplex face = s;
+			SolveTriangle(face, faces[i][0], faces[i][1], faces[i][2]);
+			Vector3 p;
+			for (int j = 0; j < face.count; ++j) {
+				p += face.points[j].w * face.weights[j];
+			}
+			float distance = Vector::LengthSquared(p);
+			if (distance < bestDistance) {
+				bestDistance	= distance;
+				best			= face;
+			}
+		}
+		if (!outsideAny) {
+			return false;
+		}
+		s = best;
+	}
+	closest = Vector3();
+	for (int i = 0; i < s.count; ++i) {
+		closest += s.points[i].w * s.weights[i];
+	}
+	return true;
+}
+
+/*
+Returns true if the volumes overlap, or are touching. Otherwise, the simplex is
+left holding the points and weights that make up the closest point between
+them, and closest is set to that point on the Minkowski difference.
+*/
+static bool GJK(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, bool withRadius, Simplex& simplex, Vector3& closest) {
+	const int	maxIterations		= 64;
+	const float relativeTolerance	= 1e-5f;
+	const float touchingTolerance	= 1e-10f;
+
+	closest = worldTransformA.GetPosition() - worldTransformB.GetPosition();
+	if (Vector::LengthSquared(closest) < touchingTolerance) {
+		closest = Vector3(1, 0, 0);
+	}
+	simplex.count = 0;
+
+	for (int i = 0; i < maxIterations; ++i) {
+		SupportPoint p = GetMinkowskiSupport(volumeA, worldTransformA, volumeB, worldTransformB, -closest, withRadius);
+
+		if (simplex.count > 0) {
+			float vv = Vector::Dot(closest, closest);
+			if (vv - Vector::Dot(closest, p.w) <= relativeTolerance * vv) {
+				return false; //Can't get any closer to the origin
+			}
+			for (int j = 0; j < simplex.count; ++j) {
+				if (Vector::LengthSquared(p.w - simplex.points[j].w) < touchingTolerance) {
+					return false;
+				}
+			}
+		}
+		simplex.points[simplex.count++] = p;
+
+		if (!SolveSimplex(simplex, closest) || Vector::LengthSquared(closest) < touchingTolerance) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//EPA needs a starting polytope with some volume to it, which GJK might not have left behind
+static bool CompleteTetrahedron(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, std::vector<SupportPoint>& vertices) {
+	const float minSeparation = 1e-4f;
+	static const Vector3 axes[6] = {
+		Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 1, 0), Vector3(0, -1, 0), Vector3(0, 0, 1), Vector3(0, 0, -1)
+	};
+	auto support = [&](const Vector3& dir) {
+		return GetMinkowskiSupport(volumeA, worldTransformA, volumeB, worldTransformB, dir, true);
+	};
+
+	if (vertices.empty()) {
+		vertices.push_back(support(axes[0]));
+	}
+	if (vertices.size() == 1) {
+		for (const Vector3& axis : axes) {
+			SupportPoint p = support(axis);
+			if (Vector::Length(p.w - vertices[0].w) > minSeparation) {
+				vertices.push_back(p);
+				break;
+			}
+		}
+	}
+	if (vertices.size() == 2) {
+		Vector3 line = Vector::Normalise(vertices[1].w - vertices[0].w);
+		Vector3 axis = std::abs(line.x) < 0.57f ? Vector3(1, 0, 0) : (std::abs(line.y) < 0.57f ? Vector3(0, 1, 0) : Vector3(0, 0, 1));
+		Vector3 perpA = Vector::Normalise(Vector::Cross(line, axis));
+		Vector3 perpB = Vector::Cross(line, perpA);
+		for (int i = 0; i < 6; ++i) {
+			float angle = i * (PI / 3.0f);
+			SupportPoint p = support(perpA * std::cos(angle) + perpB * std::sin(angle));
+			if (Vector::Length(Vector::Cross(p.w - vertices[0].w, line)) > minSeparation) {
+				vertices.push_back(p);
+				break;
+			}
+		}
+	}
+	if (vertices.size() == 3) {
+		Vector3 n = Vector::Normalise(Vector::Cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w));
+		for (const Vector3& dir : { n, -n }) {
+			SupportPoint p = support(dir);
+			if (std::abs(Vector::Dot(p.w - vertices[0].w, n)) > minSeparation) {
+				vertices.push_back(p);
+				break;
+			}
+		}
+	}
+	if (vertices.size() < 4) {
+		return false;
+	}
+	//Wind the first face away from the last point, so every face built from it faces outwards
+	Vector3 a = vertices[0].w;
+	if (Vector::Dot(Vector::Cross(vertices[1].w - a, vertices[2].w - a), vertices[3].w - a) > 0.0f) {
+		std::swap(vertices[1], vertices[2]);
+	}
+	return true;
+}
+
+/*
+Expands the polytope GJK finished with out towards the surface of the
+Minkowski difference, always pushing out the face nearest the origin, until
+that face can't be pushed out any further. That face gives the shortest way
+to separate the volumes.
+*/
+static bool EPA(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, const Simplex& simplex,
+	Vector3& normal, float& depth, Vector3& pointA, Vector3& pointB) {
+	const int	maxIterations	= 64;
+	const float tolerance		= 1e-4f;
+
+	std::vector<SupportPoint> vertices(simplex.points, simplex.points + simplex.count);
+	if (!CompleteTetrahedron(volumeA, worldTransformA, volumeB, worldTransformB, vertices)) {
+		return false;
+	}
+
+	std::vector<PolytopeFace> faces;
+	std::vector<std::pair<int, int>> horizon;
+
+	auto addFace = [&](int a, int b, int c) {
+		Vector3 n = Vector::Cross(vertices[b].w - vertices[a].w, vertices[c].w - vertices[a].w);
+		float length = Vector::Length(n);
+		if (length < 1e-12f) {
+			return;
+		}
+		n = n / length;
+		faces.push_back({ a, b, c, n, Vector::Dot(n, vertices[a].w) });
+	};
+	addFace(0, 1, 2);
+	addFace(0, 3, 1);
+	addFace(0, 2, 3);
+	addFace(1, 3, 2);
+
+	int closestFace = -1;
+	for (int i = 0; i < maxIterations && !faces.empty(); ++i) {
+		closestFace = 0;
+		for (int j = 1; j < (int)faces.size(); ++j) {
+			if (faces[j].distance < faces[closestFace].distance) {
+				closestFace = j;
+			}
+		}
+		const PolytopeFace& face = faces[closestFace];
+		SupportPoint p = GetMinkowskiSupport(volumeA, worldTransformA, volumeB, worldTransformB, face.normal, true);
+		if (Vector::Dot(p.w, face.normal) - face.distance < tolerance) {
+			break;
+		}
+
+		//Every face the new point can see is replaced by faces joining it to their outline
+		int newIndex = (int)vertices.size();
+		vertices.push_back(p);
+		horizon.clear();
+		for (size_t j = 0; j < faces.size(); ) {
+			if (Vector::Dot(faces[j].normal, p.w - vertices[faces[j].a].w) <= 0.0f) {
+				++j;
+				continue;
+			}
+			int edges[3][2] = { {faces[j].a, faces[j].b}, {faces[j].b, faces[j].c}, {faces[j].c, faces[j].a} };
+			for (auto& e : edges) {
+				auto shared = std::find(horizon.begin(), horizon.end(), std::make_pair(e[1], e[0]));
+				if (shared != horizon.end()) {
+					horizon.erase(shared);
+				}
+				else {
+					horizon.emplace_back(e[0], e[1]);
+				}
+			}
+			faces[j] = faces.back();
+			faces.pop_back();
+		}
+		for (const auto& e : horizon) {
+			addFace(e.first, e.second, newIndex);
+		}
+		closestFace = -1;
+	}
+	if (faces.empty()) {
+		return false;
+	}
+	if (closestFace < 0) {
+		closestFace = 0;
+		for (int j = 1; j < (int)faces.size(); ++j) {
+			if (faces[j].distance < faces[closestFace].distance) {
+				closestFace = j;
+			}
+		}
+	}
+	const PolytopeFace& face = faces[closestFace];
+	normal	= face.normal;
+	depth	= std::max(face.distance, 0.0f);
+
+	//Where the origin projects onto the face gives the matching points on each volume
+	Vector3 v0 = vertices[face.b].w - vertices[face.a].w;
+	Vector3 v1 = vertices[face.c].w - vertices[face.a].w;
+	Vector3 v2 = normal * face.distance - vertices[face.a].w;
+	float d00 = Vector::Dot(v0, v0);
+	float d01 = Vector::Dot(v0, v1);
+	float d11 = Vector::Dot(v1, v1);
+	float d20 = Vector::Dot(v2, v0);
+	float d21 = Vector::Dot(v2, v1);
+	float denom = d00 * d11 - d01 * d01;
+	float v = 0.0f;
+	float w = 0.0f;
+	if (std::abs(denom) > 1e-12f) {
+		v = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+	}
+	float u = 1.0f - v - w;
+	pointA = vertices[face.a].a * u + vertices[face.b].a * v + vertices[face.c].a * w;
+	pointB = vertices[face.a].b * u + vertices[face.b].b * v + vertices[face.c].b * w;
+	return true;
+}
+
+bool CollisionDetection::GJKIntersection(
+	const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+
+	if (!IsSupportMapped(volumeA) || !IsSupportMapped(volumeB)) {
+		return false;
+	}
+	const float coreTolerance = 1e-4f;
+
+	float radiusA = GetCoreRadius(volumeA);
+	float radiusB = GetCoreRadius(volumeB);
+
+	Simplex simplex;
+	Vector3 closest;
+	if (!GJK(volumeA, worldTransformA, volumeB, worldTransformB, false, simplex, closest) && Vector::Length(closest) > coreTolerance) {
+		//Only the radii can be overlapping, which the closest points between the cores tell us all about
+		float distance = Vector::Length(closest);
+		if (distance >= radiusA + radiusB) {
+			return false;
+		}
+		Vector3 pointA;
+		Vector3 pointB;
+		for (int i = 0; i < simplex.count; ++i) {
+			pointA += simplex.points[i].a * simplex.weights[i];
+			pointB += simplex.points[i].b * simplex.weights[i];
+		}
+		Vector3 normal = -closest / distance;
+		pointA += normal * radiusA;
+		pointB -= normal * radiusB;
+
+		collisionInfo.AddContactPoint(pointA - worldTransformA.GetPosition(), pointB - worldTransformB.GetPosition(), normal, radiusA + radiusB - distance);
+		return true;
+	}
+
+	if (radiusA + radiusB > 0.0f) {
+		//The simplex so far was built without the radii, so it has to start again with them
+		GJK(volumeA, worldTransformA, volumeB, worldTransformB, true, simplex, closest);
+	}
+	Vector3 normal;
+	float	depth;
+	Vector3 pointA;
+	Vector3 pointB;
+	if (!EPA(volumeA, worldTransformA, volumeB, worldTransformB, simplex, normal, depth, pointA, pointB)) {
+		return false;
+	}
+	collisionInfo.AddContactPoint(pointA - worldTransformA.GetPosition(), pointB - worldTransformB.GetPosition(), normal, depth);
+	return true;
+}
+
+/*
+Finds the closest point on or in a volume to a world space point. Points inside
+the volume are their own closest point.
+*/
+bool CollisionDetection::ClosestPointOnVolume(const Vector3& point, const CollisionVolume& volume, const Transform& worldTransform, Vector3& closestPoint) {
+	Vector3 position = worldTransform.GetPosition();
+
+	if (volume.type == VolumeType::AABB) {
+		Vector3 boxSize = ((const AABBVolume&)volume).GetHalfDimensions();
+		closestPoint = position + Vector::Clamp(point - position, -boxSize, boxSize);
+		return true;
+	}
+	if (volume.type == VolumeType::OBB) {
+		Matrix3 orientation = Quaternion::RotationMatrix<Matrix3>(worldTransform.GetOrientation());
+		Vector3 boxSize = ((const OBBVolume&)volume).GetHalfDimensions();
+		Vector3 localPoint = Matrix::Transpose(orientation) * (point - position);
+		closestPoint = position + orientation * Vector::Clamp(localPoint, -boxSize, boxSize);
+		return true;
+	}
+	if (volume.type == VolumeType::ConvexHull) {
+		//GJK against a sphere with no radius gives the closest point on the hull
+		SphereVolume pointVolume(0.0f);
+		Transform pointTransform;
+		pointTransform.SetPosition(point);
+
+		Simplex simplex;
+		Vector3 closest;
+		if (GJK(volume, worldTransform, (const CollisionVolume&)pointVolume, pointTransform, false, simplex, closest)) {
+			closestPoint = point;
+			return true;
+		}
+		closestPoint = Vector3();
+		for (int i = 0; i < simplex.count; ++i) {
+			closestPoint += simplex.points[i].a * simplex.weights[i];
+		}
+		return true;
+	}
+
+	//Spheres and capsules are both a radius around a core, which is a single point for spheres
+	Vector3 core	= position;
+	float	radius	= 0.0f;
+	if (volume.type == VolumeType::Sphere) {
+		radius = ((const SphereVolume&)volume).GetRadius();
+	}
+	else if (volume.type == VolumeType::Capsule) {
+		const CapsuleVolume& capsule = (const CapsuleVolume&)volume;
+		Vector3 axis = worldTransform.GetOrientation() * Vector3(0, capsule.GetHalfHeight(), 0);
+		core	= Vector::ClosestPointOnLineSegment(position - axis, position + axis, point);
+		radius	= capsule.GetRadius();
+	}
+	else {
+		return false;
+	}
+	Vector3 delta	= point - core;
+	float distance	= Vector::Length(delta);
+	closestPoint	= distance > radius ? core + delta * (radius / distance) : point;
+	return true;
+}
+
+/*
+Conservative advancement of a sphere moving in a straight line, giving the
+fraction of the motion it can travel before touching the volume, and the
+surface normal where it does. The distance
+from a point moving in a line to a convex volume is itself convex, so stepping
+on by the gap left over the rate it's closing can never step past the first
+contact, and converges on it quickly. Spheres that start inside the volume, or
+are moving away from it, are left for the narrowphase.
+*/
+bool CollisionDetection::SphereTimeOfImpact(const Vector3& start, const Vector3& motion, float radius, const CollisionVolume& volume, const Transform& worldTransform, float& toi, Vector3& normal) {
+	const int	maxIterations	= 16;
+	const float tolerance		= 0.001f;
+
+	float t = 0.0f;
+	for (int i = 0; i < maxIterations; ++i) {
+		Vector3 point = start + motion * t;
+		Vector3 closestPoint;
+		if (!ClosestPointOnVolume(point, volume, worldTransform, closestPoint)) {
+			return false;
+		}
+		Vector3 delta	= point - closestPoint;
+		float distance	= Vector::Length(delta);
+		if (distance <= 0.0f) {
+			if (i == 0) {
+				return false;
+			}
+			break; //Rounding has carried it just past the surface
+		}
+		normal = delta / distance;
+		float closing = -Vector::Dot(motion, normal);
+		if (closing <= 0.0f) {
+			return false;
+		}
+		float gap = distance - radius;
+		if (gap <= tolerance) {
+			break;
+		}
+		t += gap / closing;
+		if (t > 1.0f) {
+			return false;
+		}
+	}
+	toi = t;
+	return true;
+}
+
 Matrix4 GenerateInverseView(const Camera &c) {
 	float pitch = c.GetPitch();
 	float yaw	= c.GetYaw();
@@ -10,6 +10,7 @@
 #include "OBBVolume.h"
 #include "SphereVolume.h"
 #include "CapsuleVolume.h"
+#include "ConvexHullVolume.h"
 #include "Ray.h"
 
 using NCL::Camera;
@@ -43,16 +44,6 @@ namespace NCL {
 				point.penetration	= p;
 			}
 
-			bool operator < (const CollisionInfo& other) const {
-				size_t otherHash = (size_t)other.a + ((size_t)other.b << 32);
-				size_t thisHash  = (size_t)a + ((size_t)b << 32);
-
-				if (thisHash < otherHash) {
-					return true;
-				}
-				return false;
-			}
-
 			bool operator ==(const CollisionInfo& other) const {
 				if (other.a == a && other.b == b) {
 					return true;
@@ -85,6 +76,8 @@ namespace NCL {
 		static bool RayOBBIntersection(const Ray&r, const Transform& worldTransform, const OBBVolume&	volume, RayCollision& collision);
 		static bool RaySphereIntersection(const Ray&r, const Transform& worldTransform, const SphereVolume& volume, RayCollision& collision);
 		static bool RayCapsuleIntersection(const Ray& r, const Transform& worldTransform, const CapsuleVolume& volume, RayCollision& collision);
+		static bool RayConvexHullIntersection(const Ray& r, const Transform& worldTransform, const ConvexHullVolume& volume, RayCollision& collision);
+		static bool RayConvexIntersection(const Ray& r, const Transform& worldTransform, const CollisionVolume& volume, float boundingRadius, RayCollision& collision);
 
 
 		static bool RayPlaneIntersection(const Ray&r, const Plane&p, RayCollision& collisions);
@@ -112,6 +105,14 @@ namespace NCL {
 			const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 
 
+		static bool GJKIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		static bool ClosestPointOnVolume(const Vector3& point, const CollisionVolume& volume, const Transform& worldTransform, Vector3& closestPoint);
+
+		static bool SphereTimeOfImpact(const Vector3& start, const Vector3& motion, float radius,
+			const CollisionVolume& volume, const Transform& worldTransform, float& toi, Vector3& normal);
+
 		static Vector3 Unproject(const Vector3& screenPos, const PerspectiveCamera& cam);
 
 		static Vector3		UnprojectScreenPosition(Vector3 position, float aspect, float fov, const PerspectiveCamera&c);
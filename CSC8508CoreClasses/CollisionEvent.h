@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <utility>
+#include "Event.h"
+#include "EventManager.h"
+#include "GameObject.h"
+#include "BoundsComponent.h"
+
+namespace NCL::CSC8508 {
+	/**
+	 * A collision between two objects starting, carrying on or ending. The physics system buffers these while it
+	 * updates, and only sends them out once the update is over, so listeners are free to move objects. They can also
+	 * remove them through GameWorld::RemoveGameObject, which holds off deleting them until the end of the frame, so
+	 * events still to be sent never point at a deleted object.
+	 */
+	class CollisionEvent : public Event {
+	public:
+		enum Phase { Begin, Stay, End };
+
+		CollisionEvent(Phase phase, BoundsComponent* a, BoundsComponent* b) {
+			this->phase = phase;
+			this->a		= a;
+			this->b		= b;
+			aLayer		= a->GetGameObject().GetLayerID();
+			bLayer		= b->GetGameObject().GetLayerID();
+		}
+
+		Phase GetPhase() const { return phase; }
+
+		BoundsComponent* GetBoundsA() const { return a; }
+		BoundsComponent* GetBoundsB() const { return b; }
+
+		Layers::LayerID GetLayerA() const { return aLayer; }
+		Layers::LayerID GetLayerB() const { return bLayer; }
+
+		/**
+		 * @return The other object in the collision, or nullptr if the given object isn't part of it
+		 */
+		BoundsComponent* GetOther(const BoundsComponent* self) const {
+			return self == a ? b : (self == b ? a : nullptr);
+		}
+
+	protected:
+		Phase				phase;
+		BoundsComponent*	a;
+		BoundsComponent*	b;
+		Layers::LayerID		aLayer;
+		Layers::LayerID		bLayer;
+	};
+
+	/**
+	 * Listeners register for the event of a single layer, and only hear about collisions involving an object on that
+	 * layer, e.g. EventManager::RegisterListener<LayerCollisionEvent<Layers::Player>>(this).
+	 */
+	template <Layers::LayerID L>
+	class LayerCollisionEvent : public CollisionEvent {
+	public:
+		LayerCollisionEvent(const CollisionEvent& e) : CollisionEvent(e) {}
+	};
+
+	template <int L>
+	void CallLayerCollisionListeners(const CollisionEvent& e) {
+		LayerCollisionEvent<(Layers::LayerID)L> layerEvent(e);
+		EventManager::Call(&layerEvent);
+	}
+
+	template <int... L>
+	constexpr auto MakeLayerCollisionCalls(std::integer_sequence<int, L...>) {
+		return std::array<void (*)(const CollisionEvent&), sizeof...(L)>{ &CallLayerCollisionListeners<L>... };
+	}
+
+	/**
+	 * Sends a collision event to the listeners of the given layer. Each layer's listeners are a different event type,
+	 * so this looks up the call for the layer in a table rather than switching over every layer.
+	 */
+	inline void CallLayerCollisionListeners(Layers::LayerID layer, const CollisionEvent& e) {
+		static constexpr auto calls = MakeLayerCollisionCalls(std::make_integer_sequence<int, Layers::LayerCount>());
+		calls[layer](e);
+	}
+}
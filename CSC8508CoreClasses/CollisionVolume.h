@@ -1,4 +1,6 @@
 #pragma once
+#include "ObjectPool.h"
+
 namespace NCL {
 	enum class VolumeType {
 		AABB	= 1,
@@ -7,16 +9,17 @@ namespace NCL {
 		Mesh	= 8,
 		Capsule = 16,
 		Compound= 32,
+		ConvexHull = 64,
 		Invalid = 256
 	};
 
-	class CollisionVolume
+	class CollisionVolume : public CSC8508::PoolAllocated<CollisionVolume>
 	{
 	public:
 		CollisionVolume() {
 			type = VolumeType::Invalid;
 		}
-		~CollisionVolume() {}
+		virtual ~CollisionVolume() {}
 
 		VolumeType type;
 		bool isTrigger = false;
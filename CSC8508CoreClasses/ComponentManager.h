@@ -4,7 +4,6 @@
 
 #ifndef COMPONENTMANAGER_H
 #define COMPONENTMANAGER_H
-#include <typeindex>
 #include <iostream>
 #include <fstream>
 
@@ -28,24 +27,26 @@ namespace NCL::CSC8508
             requires std::is_base_of_v<IComponent, T>
         T* AddComponent(Args&&... args) {
             T* component = new T(std::forward<Args>(args)...);
-            componentsByType[typeid(T)].push_back(component);
+            ComponentTypeID id = ComponentType::ID<T>();
+            if (id >= componentsByType.size()) {
+                componentsByType.resize(id + 1);
+            }
+            componentsByType[id].push_back(component);
             return component;
         }
 
         template <typename T>
             requires std::is_base_of_v<IComponent, T>
         T* TryGetComponent() {
-            auto& components = componentsByType[typeid(T)];
-            for (IComponent* component : components) {
-                if (std::strcmp(component->GetType(), typeid(T).name()) == 0) {
-                    return static_cast<T*>(component);
-                }
+            ComponentTypeID id = ComponentType::ID<T>();
+            if (id >= componentsByType.size() || componentsByType[id].empty()) {
+                return nullptr;
             }
-            return nullptr;
+            return static_cast<T*>(componentsByType[id].front());
         }
 
         void Clear() {
-            for (auto& [type, components] : componentsByType) {
+            for (auto& components : componentsByType) {
                 for (IComponent* component : components) {
                     delete component;
                 }
@@ -55,7 +56,7 @@ namespace NCL::CSC8508
 
     private:
         ComponentManager() = default;
-        std::unordered_map<std::type_index, std::vector<IComponent*>> componentsByType;
+        std::vector<std::vector<IComponent*>> componentsByType; // Indexed by ComponentType::ID
     };
 }
 
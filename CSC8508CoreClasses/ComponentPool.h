@@ -0,0 +1,78 @@
+//
+// Contributors: Alasdair
+//
+
+#ifndef COMPONENTPOOL_H
+#define COMPONENTPOOL_H
+
+#include <memory>
+#include "IComponent.h"
+
+namespace NCL::CSC8508
+{
+	/**
+	 * Storage for every component of one type, in fixed size chunks. Components are packed next to each other in the
+	 * order they're made, so systems walking them touch memory mostly in order, and chunks never move, so pointers to
+	 * components stay valid for as long as the component lives. Freed slots are reused before a new chunk is made.
+	 *
+	 * Components should only be made and destroyed from the main thread.
+	 */
+	template <typename T>
+	requires std::is_base_of_v<IComponent, T>
+	class ComponentPool
+	{
+	public:
+		static ComponentPool& Instance() {
+			static ComponentPool instance;
+			return instance;
+		}
+
+		ComponentPool(const ComponentPool&) = delete;
+		ComponentPool& operator=(const ComponentPool&) = delete;
+
+		template <typename... Args>
+		T* Create(Args&&... args) {
+			void* slot;
+			if (!freeSlots.empty()) {
+				slot = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else {
+				if (chunks.empty() || chunkUsed == ChunkSize) {
+					chunks.push_back(std::make_unique<Chunk>());
+					chunkUsed = 0;
+				}
+				slot = chunks.back()->slots[chunkUsed++];
+			}
+			return new (slot) T(std::forward<Args>(args)...);
+		}
+
+		void Destroy(T* component) {
+			component->~T();
+			freeSlots.push_back(component);
+		}
+
+		/**
+		 * Function destroys a component known to be a T, for owners that only hold IComponent pointers.
+		 * @param component the component to destroy
+		 */
+		static void DestroyComponent(IComponent* component) {
+			Instance().Destroy(static_cast<T*>(component));
+		}
+
+	private:
+		ComponentPool() = default;
+
+		static constexpr int ChunkSize = 64;
+
+		struct Chunk {
+			alignas(T) unsigned char slots[ChunkSize][sizeof(T)];
+		};
+
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		std::vector<void*> freeSlots;
+		int chunkUsed = 0;
+	};
+}
+
+#endif //COMPONENTPOOL_H
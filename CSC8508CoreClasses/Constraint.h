@@ -2,12 +2,18 @@
 
 namespace NCL {
 	namespace CSC8508 {
+		class PhysicsObject;
+
 		class Constraint	{
 		public:
 			Constraint() {}
 			virtual ~Constraint() {}
 
 			virtual void UpdateConstraint(float dt) = 0;
+
+			//The objects tied together by this constraint, so they can be put to sleep together
+			virtual PhysicsObject* GetPhysicsObjectA() const { return nullptr; }
+			virtual PhysicsObject* GetPhysicsObjectB() const { return nullptr; }
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "ContactManifold.h"
+#include "PhysicsComponent.h"
+#include "PhysicsObject.h"
+
+using namespace NCL;
+using namespace CSC8508;
+
+//How much of the remaining penetration is pushed out each step
+const float baumgarteFactor		= 0.2f;
+//Penetration that is allowed to remain, so resting contacts don't jitter in and out
+const float penetrationSlop		= 0.01f;
+//Objects hitting slower than this don't bounce, or stacks never settle
+const float restitutionThreshold = 1.0f;
+//How far a cached point can drift before it no longer describes the contact
+const float contactBreakDistance = 0.05f;
+//New points closer than this to a cached point replace it
+const float contactMatchDistance = 0.05f;
+
+static void BuildTangents(const Vector3& n, Vector3& t0, Vector3& t1) {
+	if (std::abs(n.x) >= 0.57735f) {
+		t0 = Vector::Normalise(Vector3(n.y, -n.x, 0.0f));
+	}
+	else {
+		t0 = Vector::Normalise(Vector3(0.0f, n.z, -n.y));
+	}
+	t1 = Vector::Cross(n, t0);
+}
+
+static PhysicsObject* GetPhysicsObject(BoundsComponent* b) {
+	return b->GetPhysicsComponent()->GetPhysicsObject();
+}
+
+ContactManifold::ContactManifold() {
+	boundsA		= nullptr;
+	boundsB		= nullptr;
+	physA		= nullptr;
+	physB		= nullptr;
+	pointCount	= 0;
+	friction	= 0.0f;
+	restitution = 0.0f;
+	updated		= false;
+}
+
+ContactManifold::ContactManifold(BoundsComponent* a, BoundsComponent* b) : ContactManifold() {
+	boundsA = a;
+	boundsB = b;
+}
+
+ContactManifold::~ContactManifold() {
+}
+
+void ContactManifold::AddContact(const CollisionDetection::ContactPoint& p) {
+	const Transform& transformA = boundsA->GetGameObject().GetTransform();
+	const Transform& transformB = boundsB->GetGameObject().GetTransform();
+
+	ManifoldPoint point;
+	point.anchorA		= transformA.GetOrientation().Conjugate() * p.localA;
+	point.anchorB		= transformB.GetOrientation().Conjugate() * p.localB;
+	point.normal		= p.normal;
+	point.separation	= (transformA.GetPosition() + p.localA) - (transformB.GetPosition() + p.localB);
+	point.penetration	= p.penetration;
+	point.depth			= p.penetration;
+	point.normalImpulse		= 0.0f;
+	point.tangentImpulse[0] = 0.0f;
+	point.tangentImpulse[1] = 0.0f;
+
+	int index = FindMatchingPoint(point);
+	if (index >= 0) {
+		point.normalImpulse		= points[index].normalImpulse;
+		point.tangentImpulse[0] = points[index].tangentImpulse[0];
+		point.tangentImpulse[1] = points[index].tangentImpulse[1];
+	}
+	else if (pointCount < MaxPoints) {
+		index = pointCount++;
+	}
+	else {
+		index = ChoosePointToReplace(point);
+	}
+	points[index] = point;
+}
+
+/*
+Works out how far each cached point has moved since it was found, and throws
+away any that have pulled apart, or slid too far across each other.
+*/
+void ContactManifold::Refresh() {
+	const Transform& transformA = boundsA->GetGameObject().GetTransform();
+	const Transform& transformB = boundsB->GetGameObject().GetTransform();
+
+	for (int i = pointCount - 1; i >= 0; --i) {
+		ManifoldPoint& p = points[i];
+		Vector3 worldA = transformA.GetPosition() + transformA.GetOrientation() * p.anchorA;
+		Vector3 worldB = transformB.GetPosition() + transformB.GetOrientation() * p.anchorB;
+
+		Vector3 moved		= (worldA - worldB) - p.separation;
+		float	normalMove	= Vector::Dot(moved, p.normal);
+		Vector3 slide		= moved - (p.normal * normalMove);
+
+		p.depth = p.penetration + normalMove;
+
+		if (p.depth < -contactBreakDistance || Vector::Dot(slide, slide) > contactBreakDistance * contactBreakDistance) {
+			RemovePoint(i);
+		}
+	}
+}
+
+void ContactManifold::PreSolve(float dt) {
+	physA = GetPhysicsObject(boundsA);
+	physB = GetPhysicsObject(boundsB);
+
+	friction	= (physA->GetFriction() + physB->GetFriction()) * 0.5f;
+	restitution = (physA->GetRestitution() + physB->GetRestitution()) * 0.5f;
+
+	Quaternion orientationA = boundsA->GetGameObject().GetTransform().GetOrientation();
+	Quaternion orientationB = boundsB->GetGameObject().GetTransform().GetOrientation();
+
+	float inverseMass = physA->GetInverseMass() + physB->GetInverseMass();
+
+	for (int i = 0; i < pointCount; ++i) {
+		ManifoldPoint& p = points[i];
+		p.rA = orientationA * p.anchorA;
+		p.rB = orientationB * p.anchorB;
+		BuildTangents(p.normal, p.tangents[0], p.tangents[1]);
+
+		auto effectiveMass = [&](const Vector3& axis) {
+			Vector3 angularA = Vector::Cross(physA->GetInertiaTensor() * Vector::Cross(p.rA, axis), p.rA);
+			Vector3 angularB = Vector::Cross(physB->GetInertiaTensor() * Vector::Cross(p.rB, axis), p.rB);
+			float k = inverseMass + Vector::Dot(angularA + angularB, axis);
+			return k > 0.0f ? 1.0f / k : 0.0f;
+		};
+		p.normalMass		= effectiveMass(p.normal);
+		p.tangentMass[0]	= effectiveMass(p.tangents[0]);
+		p.tangentMass[1]	= effectiveMass(p.tangents[1]);
+
+		p.velocityBias = (baumgarteFactor / dt) * std::max(p.depth - penetrationSlop, 0.0f);
+
+		float approachSpeed = Vector::Dot(GetRelativeVelocity(p), p.normal);
+		if (approachSpeed < -restitutionThreshold) {
+			p.velocityBias = std::max(p.velocityBias, -restitution * approachSpeed);
+		}
+	}
+}
+
+void ContactManifold::WarmStart() {
+	for (int i = 0; i < pointCount; ++i) {
+		const ManifoldPoint& p = points[i];
+		Vector3 impulse =	(p.normal * p.normalImpulse) +
+							(p.tangents[0] * p.tangentImpulse[0]) +
+							(p.tangents[1] * p.tangentImpulse[1]);
+		ApplyImpulse(p, impulse);
+	}
+}
+
+/*
+One pass of the sequential impulse solver. Friction is solved first, limited
+by the normal impulse found so far, then the normal impulse, which is only
+ever allowed to push the objects apart.
+*/
+void ContactManifold::Solve() {
+	for (int i = 0; i < pointCount; ++i) {
+		ManifoldPoint& p = points[i];
+
+		float maxFriction = friction * p.normalImpulse;
+		for (int t = 0; t < 2; ++t) {
+			float speed		= Vector::Dot(GetRelativeVelocity(p), p.tangents[t]);
+			float lambda	= -speed * p.tangentMass[t];
+
+			float oldImpulse	= p.tangentImpulse[t];
+			p.tangentImpulse[t] = std::clamp(oldImpulse + lambda, -maxFriction, maxFriction);
+			ApplyImpulse(p, p.tangents[t] * (p.tangentImpulse[t] - oldImpulse));
+		}
+
+		float speed		= Vector::Dot(GetRelativeVelocity(p), p.normal);
+		float lambda	= (p.velocityBias - speed) * p.normalMass;
+
+		float oldImpulse	= p.normalImpulse;
+		p.normalImpulse		= std::max(oldImpulse + lambda, 0.0f);
+		ApplyImpulse(p, p.normal * (p.normalImpulse - oldImpulse));
+	}
+}
+
+int ContactManifold::FindMatchingPoint(const ManifoldPoint& p) const {
+	float closest = contactMatchDistance * contactMatchDistance;
+	int found = -1;
+	for (int i = 0; i < pointCount; ++i) {
+		Vector3 offset = points[i].anchorA - p.anchorA;
+		float distance = Vector::Dot(offset, offset);
+		if (distance <= closest) {
+			closest = distance;
+			found	= i;
+		}
+	}
+	return found;
+}
+
+/*
+When the manifold is full, the new point always goes in. It replaces whichever
+cached point leaves the largest spread of points behind, so the contact area
+stays as wide as possible, but the deepest point is never thrown away.
+*/
+int ContactManifold::ChoosePointToReplace(const ManifoldPoint& p) const {
+	int deepest = -1;
+	float maxDepth = p.depth;
+	for (int i = 0; i < pointCount; ++i) {
+		if (points[i].depth > maxDepth) {
+			maxDepth	= points[i].depth;
+			deepest		= i;
+		}
+	}
+	int best = 0;
+	float bestArea = -1.0f;
+	for (int i = 0; i < pointCount; ++i) {
+		if (i == deepest) {
+			continue;
+		}
+		Vector3 q[MaxPoints];
+		for (int j = 0; j < pointCount; ++j) {
+			q[j] = (j == i) ? p.anchorA : points[j].anchorA;
+		}
+		float area = std::max({
+			Vector::LengthSquared(Vector::Cross(q[0] - q[1], q[2] - q[3])),
+			Vector::LengthSquared(Vector::Cross(q[0] - q[2], q[1] - q[3])),
+			Vector::LengthSquared(Vector::Cross(q[0] - q[3], q[1] - q[2]))
+		});
+		if (area > bestArea) {
+			bestArea	= area;
+			best		= i;
+		}
+	}
+	return best;
+}
+
+void ContactManifold::RemovePoint(int i) {
+	points[i] = points[pointCount - 1];
+	pointCount--;
+}
+
+Vector3 ContactManifold::GetRelativeVelocity(const ManifoldPoint& p) const {
+	Vector3 velocityA = physA->GetLinearVelocity() + Vector::Cross(physA->GetAngularVelocity(), p.rA);
+	Vector3 velocityB = physB->GetLinearVelocity() + Vector::Cross(physB->GetAngularVelocity(), p.rB);
+	return velocityB - velocityA;
+}
+
+void ContactManifold::ApplyImpulse(const ManifoldPoint& p, const Vector3& impulse) {
+	physA->ApplyLinearImpulse(-impulse);
+	physB->ApplyLinearImpulse(impulse);
+
+	physA->ApplyAngularImpulse(Vector::Cross(p.rA, -impulse));
+	physB->ApplyAngularImpulse(Vector::Cross(p.rB, impulse));
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8508 {
+		class PhysicsObject;
+
+		struct ManifoldPoint {
+			Vector3 anchorA;		//Offsets from each object's centre, in that object's own space
+			Vector3 anchorB;
+			Vector3 normal;			//World space, pointing from A to B
+			Vector3 separation;		//World point on A minus world point on B, when found
+			float	penetration;	//As reported by the narrowphase
+			float	depth;			//Current estimate, as the objects have moved since
+
+			//Accumulated over a step, and carried into the next to warm start it
+			float	normalImpulse;
+			float	tangentImpulse[2];
+
+			//Rebuilt at the start of every step
+			Vector3 rA;
+			Vector3 rB;
+			Vector3 tangents[2];
+			float	normalMass;
+			float	tangentMass[2];
+			float	velocityBias;
+		};
+
+		/*
+		The narrowphase only ever finds one point per pair. A manifold holds on
+		to the points found over the last few steps for as long as they stay
+		valid, so a box resting on its face ends up supported at its corners
+		rather than rocking about a single point.
+
+		Each point keeps the impulse applied to it last step, which is applied
+		again up front so the solver starts near last step's answer.
+		*/
+		class ContactManifold {
+		public:
+			static const int MaxPoints = 4;
+
+			ContactManifold();
+			ContactManifold(BoundsComponent* a, BoundsComponent* b);
+			~ContactManifold();
+
+			void AddContact(const CollisionDetection::ContactPoint& p);
+			void Refresh();
+
+			void PreSolve(float dt);
+			void WarmStart();
+			void Solve();
+
+			BoundsComponent* GetBoundsA() const {
+				return boundsA;
+			}
+
+			BoundsComponent* GetBoundsB() const {
+				return boundsB;
+			}
+
+			int GetPointCount() const {
+				return pointCount;
+			}
+
+			const ManifoldPoint& GetPoint(int i) const {
+				return points[i];
+			}
+
+			bool WasUpdated() const {
+				return updated;
+			}
+
+			void SetUpdated(bool state) {
+				updated = state;
+			}
+
+		protected:
+			int		FindMatchingPoint(const ManifoldPoint& p) const;
+			int		ChoosePointToReplace(const ManifoldPoint& p) const;
+			void	RemovePoint(int i);
+
+			Vector3 GetRelativeVelocity(const ManifoldPoint& p) const;
+			void	ApplyImpulse(const ManifoldPoint& p, const Vector3& impulse);
+
+			BoundsComponent* boundsA;
+			BoundsComponent* boundsB;
+
+			PhysicsObject* physA;
+			PhysicsObject* physB;
+
+			ManifoldPoint points[MaxPoints];
+			int		pointCount;
+
+			float	friction;
+			float	restitution;
+			bool	updated;
+		};
+	}
+}
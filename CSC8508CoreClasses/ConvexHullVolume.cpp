@@ -0,0 +1,47 @@
+#include "ConvexHullVolume.h"
+
+using namespace NCL;
+
+ConvexHullVolume::ConvexHullVolume(const std::vector<Vector3>& hullPoints) {
+	type = VolumeType::ConvexHull;
+	SetPoints(hullPoints);
+}
+
+ConvexHullVolume::ConvexHullVolume(const Rendering::Mesh& mesh) {
+	type = VolumeType::ConvexHull;
+	SetPoints(mesh.GetPositionData());
+}
+
+void ConvexHullVolume::SetPoints(const std::vector<Vector3>& hullPoints) {
+	const float weldDistance = 0.0001f;
+
+	points.clear();
+	halfSizes = Vector3();
+	for (const Vector3& p : hullPoints) {
+		bool repeated = false;
+		for (const Vector3& q : points) {
+			if (Vector::LengthSquared(p - q) < weldDistance * weldDistance) {
+				repeated = true;
+				break;
+			}
+		}
+		if (repeated) {
+			continue;
+		}
+		points.push_back(p);
+		halfSizes = Vector::Max(halfSizes, Vector3(std::abs(p.x), std::abs(p.y), std::abs(p.z)));
+	}
+}
+
+Vector3 ConvexHullVolume::GetSupport(const Vector3& localDirection) const {
+	Vector3 best;
+	float bestDistance = -FLT_MAX;
+	for (const Vector3& p : points) {
+		float d = Vector::Dot(p, localDirection);
+		if (d > bestDistance) {
+			bestDistance	= d;
+			best			= p;
+		}
+	}
+	return best;
+}
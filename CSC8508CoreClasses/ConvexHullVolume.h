@@ -0,0 +1,39 @@
+#pragma once
+#include "CollisionVolume.h"
+#include "Mesh.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+
+	/*
+	A convex volume around a set of points, relative to the object's position and
+	orientation, such as the vertices of a simplified collision mesh. Points that
+	end up inside the hull do no harm, as they're never the furthest point in any
+	direction, so no hull building is needed - repeated points are just dropped.
+	*/
+	class ConvexHullVolume : public CollisionVolume
+	{
+	public:
+		ConvexHullVolume(const std::vector<Vector3>& hullPoints);
+		ConvexHullVolume(const Rendering::Mesh& mesh);
+		~ConvexHullVolume() {}
+
+		const std::vector<Vector3>& GetPoints() const {
+			return points;
+		}
+
+		//The furthest point along a direction, both in the volume's local space
+		Vector3 GetSupport(const Vector3& localDirection) const;
+
+		//Largest distance from the origin along each axis
+		Vector3 GetHalfDimensions() const {
+			return halfSizes;
+		}
+
+	protected:
+		void SetPoints(const std::vector<Vector3>& hullPoints);
+
+		std::vector<Vector3> points;
+		Vector3 halfSizes;
+	};
+}
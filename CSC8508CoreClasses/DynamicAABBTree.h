@@ -0,0 +1,458 @@
+#pragma once
+#include "BoundingBox.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8508 {
+		/*
+		A persistent bounding volume hierarchy, used as a broadphase acceleration
+		structure. Leaves store 'fat' boxes: the object's real bounds grown by a
+		fixed margin, and stretched along its predicted displacement. An object
+		only has to be reinserted once it escapes its fat box, so objects that
+		aren't moving cost nothing to keep in the tree.
+
+		Nodes live in a single vector and are referenced by index, with freed
+		nodes kept on a free list, so the tree doesn't allocate once it has grown
+		to the size of the level.
+		*/
+		template<class T>
+		class DynamicAABBTree {
+		public:
+			static const int NullNode = -1;
+
+			DynamicAABBTree(float margin = 0.2f, float displacementScale = 2.0f) {
+				this->margin			= margin;
+				this->displacementScale = displacementScale;
+				root		= NullNode;
+				freeList	= NullNode;
+				leafCount	= 0;
+			}
+			~DynamicAABBTree() {
+			}
+
+			void Clear() {
+				nodes.clear();
+				root		= NullNode;
+				freeList	= NullNode;
+				leafCount	= 0;
+			}
+
+			int Insert(T object, const BoundingBox& bounds, const Vector3& displacement = Vector3()) {
+				int proxy = AllocateNode();
+				nodes[proxy].bounds = FattenBounds(bounds, displacement);
+				nodes[proxy].object = object;
+				nodes[proxy].height = 0;
+				InsertLeaf(proxy);
+				leafCount++;
+				return proxy;
+			}
+
+			void Remove(int proxy) {
+				RemoveLeaf(proxy);
+				FreeNode(proxy);
+				leafCount--;
+			}
+
+			/*
+			Call whenever the object may have moved. Returns true if the object
+			escaped its fat box (or the box has become far too large for it), and
+			so had to be reinserted.
+			*/
+			bool Move(int proxy, const BoundingBox& bounds, const Vector3& displacement = Vector3()) {
+				BoundingBox fatBounds = FattenBounds(bounds, displacement);
+				const BoundingBox& treeBounds = nodes[proxy].bounds;
+
+				if (treeBounds.Contains(bounds)) {
+					Vector3 slack = Vector3(margin, margin, margin) * 4.0f;
+					BoundingBox hugeBounds(fatBounds.min - slack, fatBounds.max + slack);
+					if (hugeBounds.Contains(treeBounds)) {
+						return false;
+					}
+				}
+				RemoveLeaf(proxy);
+				nodes[proxy].bounds = fatBounds;
+				InsertLeaf(proxy);
+				return true;
+			}
+
+			T GetObject(int proxy) const {
+				return nodes[proxy].object;
+			}
+
+			const BoundingBox& GetFatBounds(int proxy) const {
+				return nodes[proxy].bounds;
+			}
+
+			int GetLeafCount() const {
+				return leafCount;
+			}
+
+			int GetHeight() const {
+				return root == NullNode ? 0 : nodes[root].height;
+			}
+
+			/*
+			Calls func for every object whose fat box overlaps the given bounds.
+			Returning false from func stops the query early. Doesn't touch any
+			shared state, so any number of queries can run at the same time.
+			*/
+			template <typename F>
+			void Query(const BoundingBox& bounds, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				TraversalStack stack;
+				stack.Push(root);
+
+				while (!stack.IsEmpty()) {
+					const Node& node = nodes[stack.Pop()];
+					if (!node.bounds.Overlaps(bounds)) {
+						continue;
+					}
+					if (node.IsLeaf()) {
+						if (!func(node.object)) {
+							return;
+						}
+					}
+					else {
+						stack.Push(node.child1);
+						stack.Push(node.child2);
+					}
+				}
+			}
+
+			/*
+			Calls func(object, maxDistance) for every object whose fat box is hit
+			by the ray within maxDistance, with each box grown by radius, so the
+			same walk serves sphere casts. func can shorten maxDistance to skip
+			anything further away than a hit it has already found, and returning
+			false stops the query early. As with Query, it's safe to run several
+			at once.
+			*/
+			template <typename F>
+			void RayQuery(const Vector3& origin, const Vector3& direction, float maxDistance, F&& func, float radius = 0.0f) const {
+				if (root == NullNode) {
+					return;
+				}
+				Vector3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+				Vector3 grow(radius, radius, radius);
+
+				TraversalStack stack;
+				stack.Push(root);
+
+				while (!stack.IsEmpty()) {
+					const Node& node = nodes[stack.Pop()];
+					BoundingBox bounds(node.bounds.min - grow, node.bounds.max + grow);
+					if (!bounds.RayIntersects(origin, invDirection, maxDistance)) {
+						continue;
+					}
+					if (node.IsLeaf()) {
+						if (!func(node.object, maxDistance)) {
+							return;
+						}
+					}
+					else {
+						stack.Push(node.child1);
+						stack.Push(node.child2);
+					}
+				}
+			}
+
+		protected:
+			struct Node {
+				BoundingBox bounds;
+				T		object;
+				int		parent; //Doubles as the next free node when on the free list
+				int		child1;
+				int		child2;
+				int		height; //0 for leaves, -1 for free nodes
+
+				bool IsLeaf() const {
+					return child1 == NullNode;
+				}
+			};
+
+			/*
+			Most trees will never get deeper than the inline storage, so the
+			common case doesn't touch the heap.
+			*/
+			class TraversalStack {
+			public:
+				TraversalStack() {
+					count = 0;
+				}
+				void Push(int id) {
+					if (count < InlineSize) {
+						inlineStack[count] = id;
+					}
+					else {
+						overflow.push_back(id);
+					}
+					count++;
+				}
+				int Pop() {
+					count--;
+					if (count < InlineSize) {
+						return inlineStack[count];
+					}
+					int id = overflow.back();
+					overflow.pop_back();
+					return id;
+				}
+				bool IsEmpty() const {
+					return count == 0;
+				}
+			protected:
+				static const int InlineSize = 128;
+				int inlineStack[InlineSize];
+				std::vector<int> overflow;
+				int count;
+			};
+
+			BoundingBox FattenBounds(const BoundingBox& bounds, const Vector3& displacement) const {
+				Vector3 grow = Vector3(margin, margin, margin);
+				BoundingBox fat(bounds.min - grow, bounds.max + grow);
+
+				Vector3 d = displacement * displacementScale;
+				for (int i = 0; i < 3; ++i) {
+					if (d[i] < 0.0f) {
+						fat.min[i] += d[i];
+					}
+					else {
+						fat.max[i] += d[i];
+					}
+				}
+				return fat;
+			}
+
+			int AllocateNode() {
+				int id;
+				if (freeList == NullNode) {
+					id = (int)nodes.size();
+					nodes.emplace_back();
+				}
+				else {
+					id = freeList;
+					freeList = nodes[id].parent;
+				}
+				Node& n = nodes[id];
+				n.parent	= NullNode;
+				n.child1	= NullNode;
+				n.child2	= NullNode;
+				n.height	= 0;
+				n.object	= T();
+				return id;
+			}
+
+			void FreeNode(int id) {
+				nodes[id].parent	= freeList;
+				nodes[id].height	= -1;
+				nodes[id].object	= T();
+				freeList = id;
+			}
+
+			float DescendCost(int child, const BoundingBox& leafBounds) const {
+				const Node& node = nodes[child];
+				float combined = BoundingBox::Combine(leafBounds, node.bounds).GetCost();
+				return node.IsLeaf() ? combined : combined - node.bounds.GetCost();
+			}
+
+			void InsertLeaf(int leaf) {
+				if (root == NullNode) {
+					root = leaf;
+					nodes[root].parent = NullNode;
+					return;
+				}
+				//Walk down the tree, picking the child that grows the least
+				BoundingBox leafBounds = nodes[leaf].bounds;
+				int index = root;
+				while (!nodes[index].IsLeaf()) {
+					const Node& node = nodes[index];
+
+					float area			= node.bounds.GetCost();
+					float combinedArea	= BoundingBox::Combine(node.bounds, leafBounds).GetCost();
+
+					float cost				= 2.0f * combinedArea;	//Making a new parent here
+					float inheritanceCost	= 2.0f * (combinedArea - area);	//Pushing the leaf further down
+
+					float cost1 = DescendCost(node.child1, leafBounds) + inheritanceCost;
+					float cost2 = DescendCost(node.child2, leafBounds) + inheritanceCost;
+
+					if (cost < cost1 && cost < cost2) {
+						break;
+					}
+					index = (cost1 < cost2) ? node.child1 : node.child2;
+				}
+				int sibling		= index;
+				int oldParent	= nodes[sibling].parent;
+				int newParent	= AllocateNode(); //May reallocate - no node references held past here
+
+				nodes[newParent].parent = oldParent;
+				nodes[newParent].bounds = BoundingBox::Combine(leafBounds, nodes[sibling].bounds);
+				nodes[newParent].height = nodes[sibling].height + 1;
+				nodes[newParent].child1 = sibling;
+				nodes[newParent].child2 = leaf;
+
+				if (oldParent != NullNode) {
+					if (nodes[oldParent].child1 == sibling) {
+						nodes[oldParent].child1 = newParent;
+					}
+					else {
+						nodes[oldParent].child2 = newParent;
+					}
+				}
+				else {
+					root = newParent;
+				}
+				nodes[sibling].parent	= newParent;
+				nodes[leaf].parent		= newParent;
+
+				RefitAncestors(nodes[leaf].parent);
+			}
+
+			void RemoveLeaf(int leaf) {
+				if (leaf == root) {
+					root = NullNode;
+					return;
+				}
+				int parent		= nodes[leaf].parent;
+				int grandParent = nodes[parent].parent;
+				int sibling		= (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+				if (grandParent != NullNode) {
+					if (nodes[grandParent].child1 == parent) {
+						nodes[grandParent].child1 = sibling;
+					}
+					else {
+						nodes[grandParent].child2 = sibling;
+					}
+					nodes[sibling].parent = grandParent;
+					FreeNode(parent);
+					RefitAncestors(grandParent);
+				}
+				else {
+					root = sibling;
+					nodes[sibling].parent = NullNode;
+					FreeNode(parent);
+				}
+			}
+
+			void RefitAncestors(int index) {
+				while (index != NullNode) {
+					index = Balance(index);
+
+					Node& node = nodes[index];
+					const Node& child1 = nodes[node.child1];
+					const Node& child2 = nodes[node.child2];
+
+					node.height = 1 + std::max(child1.height, child2.height);
+					node.bounds = BoundingBox::Combine(child1.bounds, child2.bounds);
+
+					index = node.parent;
+				}
+			}
+
+			/*
+			If either child of iA is more than one level taller than the other,
+			rotate its taller grandchild up into its place. Returns the index of
+			the node that is now at the top of this subtree.
+			*/
+			int Balance(int iA) {
+				Node* A = &nodes[iA];
+				if (A->IsLeaf() || A->height < 2) {
+					return iA;
+				}
+				int iB = A->child1;
+				int iC = A->child2;
+				Node* B = &nodes[iB];
+				Node* C = &nodes[iC];
+
+				int balance = C->height - B->height;
+
+				if (balance > 1) { //Rotate C up
+					int iF = C->child1;
+					int iG = C->child2;
+					Node* F = &nodes[iF];
+					Node* G = &nodes[iG];
+
+					C->child1 = iA;
+					C->parent = A->parent;
+					A->parent = iC;
+					ReplaceChild(C->parent, iA, iC);
+
+					if (F->height > G->height) {
+						C->child2 = iF;
+						A->child2 = iG;
+						G->parent = iA;
+						A->bounds = BoundingBox::Combine(B->bounds, G->bounds);
+						C->bounds = BoundingBox::Combine(A->bounds, F->bounds);
+						A->height = 1 + std::max(B->height, G->height);
+						C->height = 1 + std::max(A->height, F->height);
+					}
+					else {
+						C->child2 = iG;
+						A->child2 = iF;
+						F->parent = iA;
+						A->bounds = BoundingBox::Combine(B->bounds, F->bounds);
+						C->bounds = BoundingBox::Combine(A->bounds, G->bounds);
+						A->height = 1 + std::max(B->height, F->height);
+						C->height = 1 + std::max(A->height, G->height);
+					}
+					return iC;
+				}
+				if (balance < -1) { //Rotate B up
+					int iD = B->child1;
+					int iE = B->child2;
+					Node* D = &nodes[iD];
+					Node* E = &nodes[iE];
+
+					B->child1 = iA;
+					B->parent = A->parent;
+					A->parent = iB;
+					ReplaceChild(B->parent, iA, iB);
+
+					if (D->height > E->height) {
+						B->child2 = iD;
+						A->child1 = iE;
+						E->parent = iA;
+						A->bounds = BoundingBox::Combine(C->bounds, E->bounds);
+						B->bounds = BoundingBox::Combine(A->bounds, D->bounds);
+						A->height = 1 + std::max(C->height, E->height);
+						B->height = 1 + std::max(A->height, D->height);
+					}
+					else {
+						B->child2 = iE;
+						A->child1 = iD;
+						D->parent = iA;
+						A->bounds = BoundingBox::Combine(C->bounds, D->bounds);
+						B->bounds = BoundingBox::Combine(A->bounds, E->bounds);
+						A->height = 1 + std::max(C->height, D->height);
+						B->height = 1 + std::max(A->height, E->height);
+					}
+					return iB;
+				}
+				return iA;
+			}
+
+			void ReplaceChild(int parent, int oldChild, int newChild) {
+				if (parent == NullNode) {
+					root = newChild;
+				}
+				else if (nodes[parent].child1 == oldChild) {
+					nodes[parent].child1 = newChild;
+				}
+				else {
+					nodes[parent].child2 = newChild;
+				}
+			}
+
+			std::vector<Node> nodes;
+			int		root;
+			int		freeList;
+			int		leafCount;
+
+			float	margin;
+			float	displacementScale;
+		};
+	}
+}
@@ -6,6 +6,8 @@ using namespace CSC8508;
 
 GameClient::GameClient()	{
 	netHandle = enet_host_create(nullptr, 1, 1, 0, 0);
+	netPeer = nullptr;
+	lastAcknowledgedStateID = -1;
 }
 
 GameClient::~GameClient()	{
@@ -23,14 +25,13 @@ bool GameClient::Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum
 
 void GameClient::ReceivePacket(int type, GamePacket* payload, int source)
 {
-	if (payload->type == Full_State)
-	{
-		int i = 0;
-		AcknowledgePacket* ackPacket = new AcknowledgePacket(i);
-		std::cout << "Sending ackowledge package" << std::endl;
-		SendPacket(*ackPacket);
-		delete ackPacket;
-	}
+}
+
+void GameClient::AcknowledgeState(int stateID)
+{
+	AcknowledgePacket ackPacket(stateID);
+	SendPacket(ackPacket);
+	lastAcknowledgedStateID = stateID;
 }
 
 
@@ -17,6 +17,9 @@ namespace NCL {
 			void SendPacket(GamePacket&  payload);
 			void ReceivePacket(int type, GamePacket* payload, int source);
 
+			//Tells the server it can send deltas against this state from now on
+			void AcknowledgeState(int stateID);
+
 			void UpdateClient();
 		protected:	
 			_ENetPeer*	netPeer;
@@ -13,14 +13,61 @@ using namespace NCL::CSC8508;
 GameObject::GameObject(const bool newIsStatic): isStatic(newIsStatic)	{
 	worldID			= -1;
 	isEnabled		= true;
+	updateInParallel = false;
+	hasUpdate		= true;
+	hasLateUpdate	= true;
 	layerID = Layers::LayerID::Default;
 	tag = Tags::Tag::Default;
 	renderObject	= nullptr;
 	networkObject	= nullptr;
+	parent			= nullptr;
+	componentMask	= 0;
+	archetypeIndex	= -1;
+	archetypeRow	= -1;
+	std::fill(std::begin(componentSlots), std::end(componentSlots), nullptr);
 	vector<Layers::LayerID> ignoreLayers = vector<Layers::LayerID>();
 }
 
 GameObject::~GameObject()	{
+	SetParent(nullptr);
+	while (!children.empty()) {
+		children.back()->SetParent(nullptr);
+	}
 	delete renderObject;
 	delete networkObject;
+	for (size_t i = 0; i < components.size(); ++i) {
+		componentInfo[i].destroy(components[i]);
+	}
+}
+
+void GameObject::SetParent(GameObject* newParent) {
+	if (newParent == parent) {
+		return;
+	}
+	//Refused the same way as Transform::SetParent, so the two hierarchies always agree
+	for (GameObject* o = newParent; o; o = o->parent) {
+		if (o == this) {
+			return;
+		}
+	}
+	if (parent) {
+		parent->children.erase(std::remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
+	}
+	parent = newParent;
+	if (parent) {
+		parent->children.push_back(this);
+	}
+	transform.SetParent(parent ? &parent->transform : nullptr);
+}
+
+void GameObject::AddChild(GameObject* child) {
+	child->SetParent(this);
+}
+
+GameObject* GameObject::TryGetParent() {
+	return parent;
+}
+
+bool GameObject::HasParent() {
+	return parent != nullptr;
 }
@@ -6,6 +6,8 @@
 #include "Transform.h"
 #include "CollisionVolume.h"
 #include "IComponent.h"
+#include "ComponentPool.h"
+#include "ObjectPool.h"
 
 using std::vector;
 
@@ -16,7 +18,16 @@ namespace NCL::CSC8508 {
 	}
 
 	namespace Layers {
-		enum LayerID { Default, Ignore_RayCast, UI, Player, Enemy, Ignore_Collisions };
+		enum LayerID { Default, Ignore_RayCast, UI, Player, Enemy, Ignore_Collisions, LayerCount };
+
+		//One bit per layer, so sets of layers can be tested at once
+		typedef uint32_t LayerMask;
+		const int MaxLayers = 32;
+		const LayerMask AllLayers = 0xFFFFFFFF;
+
+		inline LayerMask ToMask(LayerID layerID) {
+			return 1u << layerID;
+		}
 	}
 
 	class NetworkObject;
@@ -24,16 +35,24 @@ namespace NCL::CSC8508 {
 	class PhysicsObject;
 	class BoundsComponent;
 
-	class GameObject	{
+	class GameObject : public PoolAllocated<GameObject>	{
 	public:
 		GameObject(bool isStatic = false);
-		~GameObject();
+		virtual ~GameObject();
 
 		bool IsEnabled() const { return isEnabled;}
 		bool SetEnabled(bool isEnabled) { this->isEnabled = isEnabled;  }
 
 		bool IsStatic() const { return isStatic;}
 
+		/**
+		 * Function sets whether the object's Update can run at the same time as other objects' Updates. Only set this
+		 * for objects whose Update reads the world but changes nothing beyond their own state.
+		 * @param state the new parallel update state
+		 */
+		void SetUpdateInParallel(bool state) { updateInParallel = state; }
+		bool UpdatesInParallel() const { return updateInParallel; }
+
 		Transform& GetTransform() {return transform;}
 
 
@@ -87,6 +106,10 @@ namespace NCL::CSC8508 {
 			//std::cout << "OnCollisionBegin event occured!\n";
 		}
 
+		//Sent every frame the objects are still touching, after the frame they began
+		virtual void OnCollisionStay(BoundsComponent* otherObject) {
+		}
+
 		virtual void OnCollisionEnd(BoundsComponent* otherObject) {
 			//std::cout << "OnCollisionEnd event occured!\n";
 		}
@@ -99,32 +122,119 @@ namespace NCL::CSC8508 {
 			return worldID;
 		}	
 
+		/**
+		 * Function gets the object's handle in the world it was added to. Hold on to this, rather than the object
+		 * itself, anywhere the object could be removed from the world first.
+		 * @return the handle, which finds nothing once the object has been removed
+		 */
+		SlotHandle GetHandle() const { return handle; }
+		void SetHandle(SlotHandle newHandle) { handle = newHandle; }
+
+		/**
+		 * Function adds a new component of type T to the object. Only the first ComponentType::MaxSlots component
+		 * types to be given an ID get a slot, and a column in the world's archetypes - components of any later type
+		 * are found by searching, which is slower, both here and in GameWorld::Each.
+		 * @return the new component
+		 */
 		template <typename T, typename... Args>
 		requires std::is_base_of_v<IComponent, T>
 		T* AddComponent(Args&&... args) {
-			T* component = new T(*this, std::forward<Args>(args)...);
+			T* component = ComponentPool<T>::Instance().Create(*this, std::forward<Args>(args)...);
+			ComponentTypeID id = ComponentType::ID<T>();
 			components.push_back(component);
+			componentInfo.push_back({ id, ComponentHooks<T>::Overridden(), &ComponentPool<T>::DestroyComponent });
+
+			if (id < ComponentType::MaxSlots && !componentSlots[id]) {
+				componentSlots[id] = component;
+				componentMask |= 1u << id;
+			}
 			return component;
 		}
 
+		/**
+		 * Function gets the first component of exactly type T, found by the type's slot rather than by searching.
+		 * @return the component, or nullptr if the object has none
+		 */
 		template <typename T>
 		requires std::is_base_of_v<IComponent, T>
 		T* TryGetComponent() {
+			ComponentTypeID id = ComponentType::ID<T>();
+			if (id < ComponentType::MaxSlots) {
+				return static_cast<T*>(componentSlots[id]);
+			}
 			for (IComponent* component : components) {
-				if (std::strcmp(component->GetType(), typeid(T).name()) == 0) {
+				if (typeid(*component) == typeid(T)) {
 					return static_cast<T*>(component);
 				}
 			}
 			return nullptr;
 		}
 
+		/**
+		 * Function gets the first component that is a T, or derives from one. Has to search, so only use it where a
+		 * base class lookup is really needed.
+		 * @return the component, or nullptr if the object has none
+		 */
+		template <typename T>
+		requires std::is_base_of_v<IComponent, T>
+		T* TryGetDerivedComponent() {
+			for (IComponent* component : components) {
+				if (T* derived = dynamic_cast<T*>(component)) {
+					return derived;
+				}
+			}
+			return nullptr;
+		}
+
+		int GetComponentCount() const { return (int)components.size(); }
+		IComponent* GetComponentAt(int index) const { return components[index]; }
+		ComponentTypeID GetComponentTypeID(int index) const { return componentInfo[index].type; }
+
+		// The update phases the component at the index has a hook for, see UpdateScheduler
+		UpdatePhases::PhaseMask GetComponentPhases(int index) const { return componentInfo[index].phases; }
+
+		/**
+		 * Function gets whether the object may still have something to do in Update or LateUpdate. Both start out
+		 * true, and the base versions of Update and LateUpdate clear them, so the world stops calling objects that
+		 * never overrode them. Overrides shouldn't call down to the base versions.
+		 */
+		bool HasUpdate() const { return hasUpdate; }
+		bool HasLateUpdate() const { return hasLateUpdate; }
+
+		// A bit for each component type the object has a slot filled for - objects with the same mask share an archetype
+		uint32_t GetComponentMask() const { return componentMask; }
+		IComponent* GetComponentInSlot(ComponentTypeID id) const { return componentSlots[id]; }
+
+		// Where the world keeps this object, see GameWorld::Each
+		void SetArchetypeRow(int archetype, int row) {
+			archetypeIndex	= archetype;
+			archetypeRow	= row;
+		}
+		int GetArchetypeIndex() const { return archetypeIndex; }
+		int GetArchetypeRow() const { return archetypeRow; }
+
+		template <typename T>
+		requires std::is_base_of_v<IComponent, T>
+		bool HasComponent() {
+			ComponentTypeID id = ComponentType::ID<T>();
+			if (id < ComponentType::MaxSlots) {
+				return (componentMask & (1u << id)) != 0;
+			}
+			return TryGetComponent<T>() != nullptr;
+		}
+
+		/**
+		 * Function parents the object's transform to another object's, see Transform::SetParent. Pass nullptr to
+		 * make the object a root again. Parenting to the object itself, or to one of its own children, is ignored.
+		 * @param parent the new parent
+		 */
+		void SetParent(GameObject* parent);
 		void AddChild(GameObject* child);
 		GameObject* TryGetParent();
-		void SetParent(GameObject* parent);
 		bool HasParent();
+		const vector<GameObject*>& GetChildren() const { return children; }
 		void UpdateComponents();
 		bool HasTag(Tags::Tag tag);
-		template <typename T> bool HasComponent(T type);
 
 
 		void SetLayerID(Layers::LayerID newID) { layerID = newID;}
@@ -136,21 +246,37 @@ namespace NCL::CSC8508 {
 
 	protected:
 		virtual void OnAwake() {}
-		virtual void Update(float deltaTime) {}
-		virtual void LateUpdate(float deltaTime) {}
+		virtual void Update(float deltaTime) { hasUpdate = false; }
+		virtual void LateUpdate(float deltaTime) { hasLateUpdate = false; }
 		virtual void OnEnable() {}
 		virtual void OnDisable() {}
 
+		struct ComponentInfo {
+			ComponentTypeID			type;
+			UpdatePhases::PhaseMask	phases;
+			void					(*destroy)(IComponent*); // Hands the component back to its pool
+		};
+
 		Transform transform;
 		RenderObject* renderObject;
 		NetworkObject* networkObject;
 		GameObject* parent;
+		vector<GameObject*> children;
 
 		vector<IComponent*> components; 
+		vector<ComponentInfo> componentInfo; // Matches components, index for index
+		IComponent* componentSlots[ComponentType::MaxSlots];	// Indexed by ComponentType::ID
+		uint32_t	componentMask;	// A bit for each filled slot
+		int			archetypeIndex;
+		int			archetypeRow;
 
 		bool isEnabled;
+		bool updateInParallel;
+		bool hasUpdate;
+		bool hasLateUpdate;
 		const bool isStatic;
 		int	worldID;
+		SlotHandle handle;
 
 		Layers::LayerID	layerID;
 		Tags::Tag	tag; // Change to vector
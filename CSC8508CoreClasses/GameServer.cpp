@@ -55,11 +55,28 @@ void GameServer::ReceivePacket(int type, GamePacket* payload, int source)
 	if (payload->type == Received_State) 
 	{
 		AcknowledgePacket* ackPacket = (AcknowledgePacket*) payload;
-		playerStates[source] = ackPacket->stateID;
-		std::cout << "packet recieved" << std::endl;
+		auto it = playerStates.find(source);
+		//Acks are sent unreliably, so an older one can turn up after a newer one
+		if (it != playerStates.end() && ackPacket->stateID > it->second) 
+			it->second = ackPacket->stateID;
 	}
 }
 
+int GameServer::GetLastAcknowledgedState(int playerID) const
+{
+	auto it = playerStates.find(playerID);
+	return it != playerStates.end() ? it->second : -1;
+}
+
+int GameServer::GetPlayerID(_ENetPeer* peer) const
+{
+	for (const auto& player : playerPeers) {
+		if (player.second == peer) 
+			return player.first;
+	}
+	return -1;
+}
+
 
 void GameServer::UpdateServer() {
 
@@ -71,7 +88,6 @@ void GameServer::UpdateServer() {
 	{
 		int type = event.type;
 		ENetPeer* p = event.peer;
-		int peer = p->incomingPeerID;
 
 		std::cout << "Updating event: " << type << std::endl;
 
@@ -81,7 +97,7 @@ void GameServer::UpdateServer() {
 
 			int playerID = playerPeers.size();
 			playerPeers[playerID] = p;
-			playerStates[playerID] = 0;
+			playerStates[playerID] = -1;
 
 			std::cout << "player connected" << std::endl;
 		}
@@ -89,8 +105,11 @@ void GameServer::UpdateServer() {
 		{
 			auto it = std::find_if(playerPeers.begin(), playerPeers.end(), [&](const auto& pair) { return pair.second == event.peer; });
 
-			if (it != playerPeers.end()) 
+			if (it != playerPeers.end()) {
+				playerStates.erase(it->first);
+				interest.RemovePlayer(it->first);
 				playerPeers.erase(it);
+			}
 
 			std::cout << "player disconnected" << std::endl;
 
@@ -98,7 +117,7 @@ void GameServer::UpdateServer() {
 		else if (type == ENetEventType::ENET_EVENT_TYPE_RECEIVE) 
 		{
 			GamePacket* packet = (GamePacket*)event.packet->data;
-			ProcessPacket(packet, peer);
+			ProcessPacket(packet, GetPlayerID(p));
 		}		
 		enet_packet_destroy(event.packet);
 
@@ -110,11 +129,11 @@ void GameServer::SetGameWorld(GameWorld &g)
 	gameWorld = &g;
 }
 
-bool GameServer::SendPacketToPeer(GamePacket* packet, int playerID) 
+bool GameServer::SendPacketToPeer(GamePacket* packet, int playerID, bool reliable) 
 {
 	auto it = playerPeers.find(playerID);
 	if (it != playerPeers.end()) {
-		ENetPacket* dataPacket = enet_packet_create(packet, packet->GetTotalSize(), ENET_PACKET_FLAG_RELIABLE);
+		ENetPacket* dataPacket = enet_packet_create(packet, packet->GetTotalSize(), reliable ? ENET_PACKET_FLAG_RELIABLE : 0);
 		enet_peer_send(it->second, 0, dataPacket);
 	}
 	return true;
@@ -1,5 +1,6 @@
 #pragma once
 #include "NetworkBase.h"
+#include "InterestManager.h"
 
 namespace NCL {
 	namespace CSC8508 {
@@ -16,21 +17,31 @@ namespace NCL {
 
 			bool SendGlobalPacket(int msgID);
 			bool SendGlobalPacket(GamePacket& packet);
-			bool SendPacketToPeer(GamePacket* packet, int playerID);
+			bool SendPacketToPeer(GamePacket* packet, int playerID, bool reliable = true);
 			void ReceivePacket(int type, GamePacket* payload, int source);
 
+			//The newest snapshot the player has said they received, or -1 if none yet
+			int GetLastAcknowledgedState(int playerID) const;
+
+			InterestManager& GetInterest() {
+				return interest;
+			}
+
 
 			std::unordered_map<int, _ENetPeer*> playerPeers;
 
 			virtual void UpdateServer();
 
 		protected:
+			int GetPlayerID(_ENetPeer* peer) const;
+
 			int			port;
 			int			clientMax;
 			int			clientCount;
 
 			GameWorld*	gameWorld;
 			std::unordered_map<int, int> playerStates;
+			InterestManager interest;
 
 
 			int incomingDataRate;
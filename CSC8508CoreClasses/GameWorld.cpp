@@ -3,6 +3,8 @@
 #include "Constraint.h"
 #include "CollisionDetection.h"
 #include "Camera.h"
+#include "PhysicsObject.h"
+#include "RenderObject.h"
 
 
 using namespace NCL;
@@ -13,96 +15,334 @@ GameWorld::GameWorld()	{
 	shuffleObjects		= false;
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+	transformOrderState	= -1;
+	transformOrderVersion = 0;
+
+	scheduler.AddSystem(UpdatePhases::Update, [this](float dt) { UpdateObjects(dt); });
+	scheduler.AddSystem(UpdatePhases::LateUpdate, [this](float dt) { LateUpdateObjects(dt); });
 }
 
 GameWorld::~GameWorld()	{
 }
 
 void GameWorld::Clear() {
-	gameObjects.clear();
+	for (GameObject* o : pendingDeletes) {
+		delete o;
+	}
+	pendingDeletes.clear();
+	removedObjects.clear();
+	gameObjects.Clear();
+	updatingObjects.clear();
+	scheduler.ClearComponents();
+	archetypes.clear();
+	physicsComponents.Clear();
+	boundsComponents.Clear();
 	constraints.clear();
+	boundsTree.Clear();
+	boundsSweep.Clear();
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
 }
 
 void GameWorld::ClearAndErase() {
-	for (auto& i : gameObjects) {
+	for (auto& i : gameObjects.Values()) {
 		delete i;
 	}
 	for (auto& i : constraints) {
 		delete i;
 	}
 	Clear();
+
+	//With the level gone, each pool's memory can go back in one go - unless something outside the world is still alive
+	ObjectPool<GameObject>::Instance().Reset();
+	ObjectPool<CollisionVolume>::Instance().Reset();
+	ObjectPool<PhysicsObject>::Instance().Reset();
+	ObjectPool<RenderObject>::Instance().Reset();
 }
 
 void GameWorld::AddGameObject(GameObject* o) {
-	gameObjects.emplace_back(o);
+	o->SetHandle(gameObjects.Insert(o));
 	o->SetWorldID(worldIDCounter++);
 	worldStateCounter++;
+	AddToArchetype(o);
+
+	//An object removed and added back before the flush is still in the update list
+	auto removed = std::find(removedObjects.begin(), removedObjects.end(), o);
+	if (removed != removedObjects.end()) {
+		removedObjects.erase(removed);
+	}
+	else {
+		updatingObjects.push_back(o);
+	}
+	for (int i = 0; i < o->GetComponentCount(); ++i) {
+		scheduler.AddComponent(o->GetComponentAt(i), o->GetComponentTypeID(i), o->GetComponentPhases(i));
+	}
 
 	auto bounds = o->TryGetComponent<BoundsComponent>();
 	auto phys = o->TryGetComponent<PhysicsComponent>();
 
-	if (bounds)
-		boundsComponents.emplace_back(bounds);
+	if (bounds) {
+		bounds->SetWorldHandle(boundsComponents.Insert(bounds));
+		bounds->UpdateBroadphaseAABB();
+		bounds->SetBroadphaseProxy(boundsTree.Insert(bounds, bounds->GetWorldBounds()));
+		bounds->SetSweepProxy(boundsSweep.Insert(bounds, bounds->GetWorldBounds()));
+	}
 
 	if (phys)
-		physicsComponents.emplace_back(phys);
+		phys->SetWorldHandle(physicsComponents.Insert(phys));
 
 	o->InvokeOnAwake();
 }
 
 void GameWorld::RemoveGameObject(GameObject* o, bool andDelete) {
-	gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
+	if (!gameObjects.Remove(o->GetHandle())) {
+		return;
+	}
+	o->SetHandle(SlotHandle());
+	RemoveFromArchetype(o);
+	removedObjects.push_back(o);
+
+	for (int i = 0; i < o->GetComponentCount(); ++i) {
+		scheduler.RemoveComponent(o->GetComponentAt(i), o->GetComponentTypeID(i), o->GetComponentPhases(i));
+	}
+
+	auto bounds = o->TryGetComponent<BoundsComponent>();
+	if (bounds) {
+		boundsComponents.Remove(bounds->GetWorldHandle());
+		bounds->SetWorldHandle(SlotHandle());
+	}
+	if (bounds && bounds->GetBroadphaseProxy() != DynamicAABBTree<BoundsComponent*>::NullNode) {
+		boundsTree.Remove(bounds->GetBroadphaseProxy());
+		bounds->SetBroadphaseProxy(DynamicAABBTree<BoundsComponent*>::NullNode);
+	}
+	if (bounds && bounds->GetSweepProxy() != SweepAndPrune<BoundsComponent*>::NullProxy) {
+		boundsSweep.Remove(bounds->GetSweepProxy());
+		bounds->SetSweepProxy(SweepAndPrune<BoundsComponent*>::NullProxy);
+	}
+	auto phys = o->TryGetComponent<PhysicsComponent>();
+	if (phys) {
+		physicsComponents.Remove(phys->GetWorldHandle());
+		phys->SetWorldHandle(SlotHandle());
+	}
+	//Whatever the object was holding up, or tied to, has to move on without it. Objects it was only touching are woken by the physics system
+	if (phys && phys->GetPhysicsObject()) {
+		PhysicsObject* object = phys->GetPhysicsObject();
+		object->WakeUp();
+		for (Constraint* c : constraints) {
+			if (c->GetPhysicsObjectA() == object && c->GetPhysicsObjectB()) {
+				c->GetPhysicsObjectB()->WakeUp();
+			}
+			else if (c->GetPhysicsObjectB() == object && c->GetPhysicsObjectA()) {
+				c->GetPhysicsObjectA()->WakeUp();
+			}
+		}
+	}
 	if (andDelete) {
-		delete o;
+		pendingDeletes.push_back(o);
 	}
 	worldStateCounter++;
 }
 
+void GameWorld::AddToArchetype(GameObject* o) {
+	uint32_t mask = o->GetComponentMask();
+
+	int index = 0;
+	while (index < (int)archetypes.size() && archetypes[index].mask != mask) {
+		index++;
+	}
+	if (index == (int)archetypes.size()) {
+		archetypes.emplace_back();
+		archetypes.back().mask = mask;
+	}
+	Archetype& a = archetypes[index];
+	o->SetArchetypeRow(index, (int)a.objects.size());
+	a.objects.push_back(o);
+	for (ComponentTypeID id = 0; id < ComponentType::MaxSlots; ++id) {
+		if (mask & (1u << id)) {
+			a.columns[id].push_back(o->GetComponentInSlot(id));
+		}
+	}
+}
+
+//The last object in the archetype is moved into the gap, so the columns stay packed
+void GameWorld::RemoveFromArchetype(GameObject* o) {
+	if (o->GetArchetypeIndex() < 0) {
+		return;
+	}
+	Archetype& a = archetypes[o->GetArchetypeIndex()];
+	int row		= o->GetArchetypeRow();
+	int last	= (int)a.objects.size() - 1;
+
+	for (ComponentTypeID id = 0; id < ComponentType::MaxSlots; ++id) {
+		if (a.mask & (1u << id)) {
+			a.columns[id][row] = a.columns[id][last];
+			a.columns[id].pop_back();
+		}
+	}
+	a.objects[row] = a.objects[last];
+	a.objects[row]->SetArchetypeRow(o->GetArchetypeIndex(), row);
+	a.objects.pop_back();
+
+	o->SetArchetypeRow(-1, -1);
+}
+
 void GameWorld::GetPhysicsIterators(
 	PhysicsIterator& first,
 	PhysicsIterator& last) const {
 
-	first = physicsComponents.begin();
-	last = physicsComponents.end();
+	first = physicsComponents.Values().begin();
+	last = physicsComponents.Values().end();
 }
 
 void GameWorld::GetBoundsIterators(
 	BoundsIterator& first,
 	BoundsIterator& last) const {
 
-	first = boundsComponents.begin();
-	last = boundsComponents.end();
+	first = boundsComponents.Values().begin();
+	last = boundsComponents.Values().end();
 }
 
 void GameWorld::GetObjectIterators(
 	GameObjectIterator& first,
 	GameObjectIterator& last) const {
 
-	first	= gameObjects.begin();
-	last	= gameObjects.end();
+	first	= gameObjects.Values().begin();
+	last	= gameObjects.Values().end();
 }
 
 void GameWorld::OperateOnPhysicsContents(PhysicsComponentFunc f) {
-	for (PhysicsComponent* g : physicsComponents) {
+	for (PhysicsComponent* g : physicsComponents.Values()) {
 		f(g);
 	}
 }
 
 void GameWorld::OperateOnContents(GameObjectFunc f) {
-	for (GameObject* g : gameObjects) {
+	for (GameObject* g : gameObjects.Values()) {
 		f(g);
 	}
 }
 
 void GameWorld::UpdateWorld(float dt){
-	OperateOnContents(
+	scheduler.Update(dt);
+	FlushRemovedObjects();
+}
+
+/*
+Objects that have said their Update is safe to run alongside others are shared
+out across the job system first. Everything else is updated afterwards, one at
+a time, in the order it was added.
+*/
+void GameWorld::UpdateObjects(float dt) {
+	parallelUpdates.clear();
+	for (GameObject* o : updatingObjects) {
+		if (o->IsEnabled() && o->HasUpdate() && o->UpdatesInParallel() && gameObjects.Contains(o->GetHandle())) {
+			parallelUpdates.push_back(o);
+		}
+	}
+	JobSystem::Instance().ParallelFor((int)parallelUpdates.size(), 8, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			parallelUpdates[i]->InvokeUpdate(dt);
+		}
+	});
+
+	for (size_t i = 0; i < updatingObjects.size(); ++i) {
+		GameObject* o = updatingObjects[i];
+		if (o->IsEnabled() && o->HasUpdate() && !o->UpdatesInParallel() && gameObjects.Contains(o->GetHandle())) {
+			o->InvokeUpdate(dt);
+		}
+	}
+}
+
+void GameWorld::LateUpdateObjects(float dt) {
+	for (size_t i = 0; i < updatingObjects.size(); ++i) {
+		GameObject* o = updatingObjects[i];
+		if (o->IsEnabled() && o->HasLateUpdate() && gameObjects.Contains(o->GetHandle())) {
+			o->InvokeLateUpdate(dt);
+		}
+	}
+}
+
+/*
+Removed objects are taken off the update list in one pass, rather than a search
+each, along with objects that turned out to override neither Update nor
+LateUpdate - by now every enabled object has been through both at least once.
+Only then are removed objects deleted, so nothing is left pointing at them.
+Anything removed by a removal listener waits for the next flush, so every
+listener still gets to see it before it goes.
+*/
+void GameWorld::FlushRemovedObjects() {
+	deletingObjects.swap(pendingDeletes);
+	for (const auto& func : removalListeners) {
+		func();
+	}
+	updatingObjects.erase(std::remove_if(updatingObjects.begin(), updatingObjects.end(),
 		[&](GameObject* o) {
-			if (o->IsEnabled()) {
-				o->InvokeUpdate(dt);
+			return !gameObjects.Contains(o->GetHandle()) || (!o->HasUpdate() && !o->HasLateUpdate());
+		}), updatingObjects.end());
+	removedObjects.clear();
+
+	for (GameObject* o : deletingObjects) {
+		delete o;
+	}
+	deletingObjects.clear();
+}
+
+/*
+The order is only worked out again when objects or parents have changed. It's
+a counting sort on depth, so every parent comes before its children, and
+everything at one depth can be rebuilt at once, across the job system.
+*/
+void GameWorld::UpdateTransforms() {
+	if (transformOrderState != worldStateCounter || transformOrderVersion != Transform::GetHierarchyVersion()) {
+		transformOrderState		= worldStateCounter;
+		transformOrderVersion	= Transform::GetHierarchyVersion();
+
+		depthStarts.assign(1, 0);
+		for (GameObject* o : gameObjects.Values()) {
+			int depth = o->GetTransform().GetDepth();
+			if (depth + 2 > (int)depthStarts.size()) {
+				depthStarts.resize(depth + 2, 0);
+			}
+			depthStarts[depth + 1]++;
+		}
+		for (size_t i = 1; i < depthStarts.size(); ++i) {
+			depthStarts[i] += depthStarts[i - 1];
+		}
+		std::vector<int> next(depthStarts.begin(), depthStarts.end() - 1);
+		transformOrder.resize(gameObjects.Size());
+		for (GameObject* o : gameObjects.Values()) {
+			transformOrder[next[o->GetTransform().GetDepth()]++] = &o->GetTransform();
+		}
+	}
+
+	RefitMovedBounds();
+
+	Transform::BeginUpdatePass();
+	for (size_t d = 0; d + 1 < depthStarts.size(); ++d) {
+		int first = depthStarts[d];
+		JobSystem::Instance().ParallelFor(depthStarts[d + 1] - first, 256, [&](int begin, int end) {
+			for (int i = first + begin; i < first + end; ++i) {
+				transformOrder[i]->UpdateMatrix();
 			}
 		});
+	}
+}
+
+/*
+The physics system refits the boxes of the bodies it moves, but anything moved
+through its transform instead - static objects, sleeping bodies, and objects
+with no physics at all - is caught here, while its transform is still marked
+dirty, so the queries find it where it is now.
+*/
+void GameWorld::RefitMovedBounds() {
+	for (BoundsComponent* b : boundsComponents.Values()) {
+		int proxy = b->GetBroadphaseProxy();
+		if (proxy == DynamicAABBTree<BoundsComponent*>::NullNode || !b->GetGameObject().GetTransform().IsDirty()) {
+			continue;
+		}
+		b->UpdateBroadphaseAABB();
+		boundsTree.Move(proxy, b->GetWorldBounds());
+	}
 }
 
 void GameWorld::ShuffleWorldConstraints() {
@@ -110,62 +350,150 @@ void GameWorld::ShuffleWorldConstraints() {
 	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
 	std::default_random_engine e(seed);
 
-	if (shuffleObjects)
-		std::shuffle(gameObjects.begin(), gameObjects.end(), e);
+	if (shuffleObjects) {
+		for (int i = gameObjects.Size() - 1; i > 0; --i) {
+			gameObjects.SwapValues(i, std::uniform_int_distribution<int>(0, i)(e));
+		}
+	}
 
 	if (shuffleConstraints)
 		std::shuffle(constraints.begin(), constraints.end(), e);
 }
 
-bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, BoundsComponent* ignoreThis, vector<Layers::LayerID>* ignoreLayers) const {
-	RayCollision collision;
+bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, BoundsComponent* ignoreThis, Layers::LayerMask ignoreLayers) const {
+	return Raycast({ r, FLT_MAX, ignoreThis, ignoreLayers }, closestCollision, closestObject);
+}
 
-	for (auto& i : boundsComponents) {
-		if (!i->GetBoundingVolume()) 
-			continue;
-		if (i == ignoreThis) 
-			continue;
-		bool toContinue = false;
-
-		if (ignoreLayers != nullptr) {
-			for (const Layers::LayerID& var : *ignoreLayers) {
-				if (i->GetGameObject().GetLayerID() == var) {
-					toContinue = true;
-					break;
-				}
-			}
-		}
+//Nothing on these layers is ever hit by a query
+static const Layers::LayerMask unqueryableLayers = Layers::ToMask(Layers::Ignore_RayCast) | Layers::ToMask(Layers::UI);
 
-		if (toContinue)
-			continue;
+static bool IsQueryable(const BoundsComponent* b, const BoundsComponent* ignoreThis, Layers::LayerMask ignoreLayers) {
+	if (!b->GetBoundingVolume() || b == ignoreThis) {
+		return false;
+	}
+	return !(Layers::ToMask(b->GetGameObject().GetLayerID()) & (ignoreLayers | unqueryableLayers));
+}
 
-		if (i->GetGameObject().GetLayerID() == Layers::Ignore_RayCast || i->GetGameObject().GetLayerID() == Layers::UI)
-			continue;
+/*
+The queries walk the broadphase tree, so only objects whose boxes lie along the
+ray are tested, and each hit shortens the ray, so anything further away than it
+is never looked at. The physics system refits the tree every step, whichever
+broadphase it is using for collisions, and anything moved outside of physics is
+refit by UpdateTransforms.
+*/
+bool GameWorld::Raycast(const RaycastQuery& query, RayCollision& closestCollision, bool closestObject) const {
+	RayCollision collision;
 
+	boundsTree.RayQuery(query.ray.GetPosition(), query.ray.GetDirection(), query.maxDistance, [&](BoundsComponent* b, float& maxDistance) {
+		if (!IsQueryable(b, query.ignoreThis, query.ignoreLayers)) {
+			return true;
+		}
 		RayCollision thisCollision;
-		if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
-				
-			if (!closestObject) {	
-				closestCollision = collision;
-				closestCollision.node = i;
-				return true;
-			}
-			else {
-				if (thisCollision.rayDistance < collision.rayDistance) {
-					thisCollision.node = i;
-					collision = thisCollision;
-				}
-			}
+		if (!CollisionDetection::RayIntersection(query.ray, *b, thisCollision) || thisCollision.rayDistance > maxDistance) {
+			return true;
 		}
+		thisCollision.node	= b;
+		collision			= thisCollision;
+		maxDistance			= thisCollision.rayDistance;
+		return closestObject;
+	});
+
+	if (collision.node) {
+		closestCollision = collision;
+		return true;
 	}
+	return false;
+}
+
+bool GameWorld::SphereCast(const SphereCastQuery& query, RayCollision& closestCollision) const {
+	RayCollision collision;
+
+	boundsTree.RayQuery(query.start, query.direction, query.maxDistance, [&](BoundsComponent* b, float& maxDistance) {
+		if (!IsQueryable(b, query.ignoreThis, query.ignoreLayers)) {
+			return true;
+		}
+		float	toi;
+		Vector3 normal;
+		if (!CollisionDetection::SphereTimeOfImpact(query.start, query.direction * maxDistance, query.radius,
+			*b->GetBoundingVolume(), b->GetGameObject().GetTransform(), toi, normal)) {
+			return true;
+		}
+		maxDistance *= toi;
+
+		collision.node			= b;
+		collision.rayDistance	= maxDistance;
+		collision.collidedAt	= query.start + query.direction * maxDistance - normal * query.radius;
+		return true;
+	}, query.radius);
+
 	if (collision.node) {
 		closestCollision = collision;
-		closestCollision.node = collision.node;
 		return true;
 	}
 	return false;
 }
 
+//Returns how many objects were written to results, which stops at the query's maxResults
+int GameWorld::OverlapSphere(const OverlapQuery& query, BoundsComponent** results) const {
+	int count = 0;
+	if (query.maxResults <= 0) {
+		return count;
+	}
+	Vector3 halfSize(query.radius, query.radius, query.radius);
+
+	boundsTree.Query(BoundingBox::FromCentre(query.centre, halfSize), [&](BoundsComponent* b) {
+		if (!IsQueryable(b, query.ignoreThis, query.ignoreLayers)) {
+			return true;
+		}
+		Vector3 closestPoint;
+		if (!CollisionDetection::ClosestPointOnVolume(query.centre, *b->GetBoundingVolume(), b->GetGameObject().GetTransform(), closestPoint)) {
+			return true;
+		}
+		if (Vector::LengthSquared(closestPoint - query.centre) > query.radius * query.radius) {
+			return true;
+		}
+		results[count++] = b;
+		return count < query.maxResults;
+	});
+	return count;
+}
+
+//Each query only reads the world and writes its own results, so they can run in any order
+static void RunQueries(int count, JobSystem* jobs, const JobSystem::RangeFunc& func) {
+	if (jobs) {
+		jobs->ParallelFor(count, 16, func);
+	}
+	else {
+		func(0, count);
+	}
+}
+
+void GameWorld::RaycastBatch(std::span<const RaycastQuery> queries, std::span<RayCollision> results, JobSystem* jobs) const {
+	RunQueries((int)queries.size(), jobs, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			results[i] = RayCollision();
+			Raycast(queries[i], results[i]);
+		}
+	});
+}
+
+void GameWorld::SphereCastBatch(std::span<const SphereCastQuery> queries, std::span<RayCollision> results, JobSystem* jobs) const {
+	RunQueries((int)queries.size(), jobs, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			results[i] = RayCollision();
+			SphereCast(queries[i], results[i]);
+		}
+	});
+}
+
+void GameWorld::OverlapBatch(std::span<const OverlapQuery> queries, std::span<BoundsComponent*> results, std::span<int> resultCounts, JobSystem* jobs) const {
+	RunQueries((int)queries.size(), jobs, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			resultCounts[i] = OverlapSphere(queries[i], results.data() + queries[i].firstResult);
+		}
+	});
+}
+
 void GameWorld::AddConstraint(Constraint* c) {
 	constraints.emplace_back(c);
 }
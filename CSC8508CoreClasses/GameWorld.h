@@ -1,9 +1,17 @@
 #pragma once
 #include <random>
+#include <span>
 
 #include "Ray.h"
 #include "CollisionDetection.h"
 #include "QuadTree.h"
+#include "DynamicAABBTree.h"
+#include "SweepAndPrune.h"
+#include "JobSystem.h"
+#include "IComponent.h"
+#include "UpdateScheduler.h"
+#include "SlotMap.h"
+#include "GameObject.h"
 namespace NCL {
 		class Camera;
 		using Maths::Ray;
@@ -20,6 +28,46 @@ namespace NCL {
 		typedef std::vector<PhysicsComponent*>::const_iterator PhysicsIterator;
 		typedef std::vector<BoundsComponent*>::const_iterator BoundsIterator;
 
+		/*
+		Every object in the world with the same set of component types is kept
+		in the same archetype, with a column of components for each type. A
+		system can then run over every object with the components it needs by
+		walking straight down the columns of the archetypes that have them.
+		*/
+		struct Archetype {
+			uint32_t mask;
+			std::vector<GameObject*> objects;
+			std::vector<IComponent*> columns[ComponentType::MaxSlots]; //Only the columns in the mask are used
+		};
+
+		//Ray directions are normalised, and hits are reported as distances along them
+		struct RaycastQuery {
+			Ray ray;
+			float maxDistance;
+			const BoundsComponent* ignoreThis;
+			Layers::LayerMask ignoreLayers;
+		};
+
+		//Objects the sphere's centre starts inside of aren't hit
+		struct SphereCastQuery {
+			Vector3 start;
+			Vector3 direction;
+			float radius;
+			float maxDistance;
+			const BoundsComponent* ignoreThis;
+			Layers::LayerMask ignoreLayers;
+		};
+
+		//Each query writes its results to its own range of the results buffer
+		struct OverlapQuery {
+			Vector3 centre;
+			float radius;
+			const BoundsComponent* ignoreThis;
+			Layers::LayerMask ignoreLayers;
+			int firstResult;
+			int maxResults;
+		};
+
 
 		class GameWorld	{
 		public:
@@ -30,8 +78,31 @@ namespace NCL {
 			void ClearAndErase();
 
 			void AddGameObject(GameObject* o);
+
+			/*
+			Takes the object out of the world straight away, so its handle stops
+			finding it and no system sees it again. If it's to be deleted, that
+			waits until the end of UpdateWorld, so anything still holding it this
+			frame, such as buffered collision events, stays safe to use.
+			*/
 			void RemoveGameObject(GameObject* o, bool andDelete = false);
 
+			//Returns nullptr if the object has left the world
+			GameObject* GetGameObject(SlotHandle handle) const {
+				GameObject* const* o = gameObjects.Get(handle);
+				return o ? *o : nullptr;
+			}
+
+			PhysicsComponent* GetPhysicsComponent(SlotHandle handle) const {
+				PhysicsComponent* const* c = physicsComponents.Get(handle);
+				return c ? *c : nullptr;
+			}
+
+			BoundsComponent* GetBoundsComponent(SlotHandle handle) const {
+				BoundsComponent* const* c = boundsComponents.Get(handle);
+				return c ? *c : nullptr;
+			}
+
 			void AddConstraint(Constraint* c);
 			void RemoveConstraint(Constraint* c, bool andDelete = false);
 
@@ -48,10 +119,74 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
-			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, BoundsComponent* ignoreThis = nullptr, vector<Layers::LayerID>* ignoreLayers = nullptr) const;
+			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, BoundsComponent* ignoreThis = nullptr, Layers::LayerMask ignoreLayers = 0) const;
+
+			bool Raycast(const RaycastQuery& query, RayCollision& closestCollision, bool closestObject = true) const;
+			bool SphereCast(const SphereCastQuery& query, RayCollision& closestCollision) const;
+			int  OverlapSphere(const OverlapQuery& query, BoundsComponent** results) const;
+
+			/*
+			Batched queries, one result per query, written straight into the
+			caller's buffers. Given a job system, the queries are shared out
+			across its threads. Missed casts have no node set.
+			*/
+			void RaycastBatch(std::span<const RaycastQuery> queries, std::span<RayCollision> results, JobSystem* jobs = nullptr) const;
+			void SphereCastBatch(std::span<const SphereCastQuery> queries, std::span<RayCollision> results, JobSystem* jobs = nullptr) const;
+			void OverlapBatch(std::span<const OverlapQuery> queries, std::span<BoundsComponent*> results, std::span<int> resultCounts, JobSystem* jobs = nullptr) const;
 
+			//Runs every update phase of the world's scheduler
 			virtual void UpdateWorld(float dt);
 
+			/*
+			Rebuilds the matrices of every transform in the world that's changed,
+			or whose parent has, and refits the query boxes of any that moved.
+			Run once a frame, before anything is drawn.
+			*/
+			void UpdateTransforms();
+
+			UpdateScheduler& GetScheduler() {
+				return scheduler;
+			}
+
+			/*
+			Adds a function to run at the end of every UpdateWorld, once removed
+			objects are off every list but before any of them are deleted - the
+			last point anything still pointing at them can safely let go.
+			*/
+			void AddRemovalListener(const std::function<void()>& func) {
+				removalListeners.push_back(func);
+			}
+
+			/*
+			Calls func(object, components...) for every object in the world that
+			has all of the given component types. Objects can't be added to or
+			removed from the world while this runs, and components added to an
+			object after it joined the world aren't seen. Only the first
+			ComponentType::MaxSlots types to be given an ID have archetype
+			columns - asking for any later type still works, but has to search
+			every object in the world for it, rather than walking the columns.
+			*/
+			template <typename... T, typename F>
+			void Each(F&& func) {
+				if ((... || (ComponentType::ID<T>() >= ComponentType::MaxSlots))) {
+					for (GameObject* o : gameObjects.Values()) {
+						if ((... && (o->TryGetComponent<T>() != nullptr))) {
+							func(*o, *o->TryGetComponent<T>()...);
+						}
+					}
+					return;
+				}
+				uint32_t required = (0u | ... | (1u << ComponentType::ID<T>()));
+				for (Archetype& a : archetypes) {
+					if ((a.mask & required) != required) {
+						continue;
+					}
+					for (size_t row = 0; row < a.objects.size(); ++row) {
+						func(*a.objects[row], static_cast<T&>(*a.columns[ComponentType::ID<T>()][row])...);
+					}
+				}
+			}
+
 			void OperateOnContents(GameObjectFunc f);
 			void OperateOnPhysicsContents(PhysicsComponentFunc f);
 
@@ -78,10 +213,45 @@ namespace NCL {
 				return worldStateCounter;
 			}
 
+			DynamicAABBTree<BoundsComponent*>& GetBroadphaseTree() {
+				return boundsTree;
+			}
+
+			SweepAndPrune<BoundsComponent*>& GetSweepAndPrune() {
+				return boundsSweep;
+			}
+
 		protected:
-			std::vector<GameObject*> gameObjects;
-			std::vector<PhysicsComponent*> physicsComponents;
-			std::vector<BoundsComponent*> boundsComponents;
+			void AddToArchetype(GameObject* o);
+			void RemoveFromArchetype(GameObject* o);
+
+			void UpdateObjects(float dt);
+			void LateUpdateObjects(float dt);
+			void FlushRemovedObjects();
+			void RefitMovedBounds();
+
+			UpdateScheduler scheduler;
+
+			std::vector<Archetype> archetypes;
+
+			//Every transform in the world, sorted by depth, with where each depth starts
+			std::vector<Transform*> transformOrder;
+			std::vector<int> depthStarts;
+			int transformOrderState;
+			unsigned int transformOrderVersion;
+
+			SlotMap<GameObject*> gameObjects;
+			std::vector<GameObject*> updatingObjects; //Objects whose Update or LateUpdate may still do something
+			std::vector<GameObject*> parallelUpdates;
+			std::vector<GameObject*> removedObjects; //Removed since the last flush
+			std::vector<GameObject*> pendingDeletes;
+			std::vector<GameObject*> deletingObjects;
+			std::vector<std::function<void()>> removalListeners;
+			SlotMap<PhysicsComponent*> physicsComponents;
+			SlotMap<BoundsComponent*> boundsComponents;
+
+			DynamicAABBTree<BoundsComponent*> boundsTree;
+			SweepAndPrune<BoundsComponent*> boundsSweep;
 
 			std::vector<Constraint*> constraints;
 
@@ -11,6 +11,10 @@ GameObject& IComponent::GetGameObject() {
 	return this->gameObject;
 }
 
+const GameObject& IComponent::GetGameObject() const {
+	return this->gameObject;
+}
+
 bool IComponent::IsEnabled() const {
 	return this->enabled;
 }
@@ -5,13 +5,50 @@
 #ifndef ICOMPONENT_H
 #define ICOMPONENT_H
 
+#include <atomic>
 #include "Transform.h"
+#include "SlotMap.h"
 
 namespace NCL::CSC8508 
 {
 
 	class GameObject;
 
+	typedef uint32_t ComponentTypeID;
+
+	/**
+	 * Hands out a small, sequential ID to each component type the first time it's asked for, so components can be
+	 * kept in tables indexed by their type rather than searched for by name.
+	 */
+	class ComponentType
+	{
+	public:
+		// Types with an ID below this get a slot in every GameObject's component table
+		static constexpr ComponentTypeID MaxSlots = 32;
+
+		/**
+		 * Function gets the ID of a component type.
+		 * @return the ID of T, the same every time it's asked for
+		 */
+		template <typename T>
+		static ComponentTypeID ID() {
+			static const ComponentTypeID id = nextID++;
+			return id;
+		}
+
+	private:
+		static inline std::atomic<ComponentTypeID> nextID = 0;
+	};
+
+	namespace UpdatePhases
+	{
+		// The parts of a frame, in the order they run
+		enum Phase { PreUpdate, Update, PhysicsStep, LateUpdate, PreRender, PhaseCount };
+
+		// One bit per phase
+		typedef uint32_t PhaseMask;
+	}
+
 	class IComponent
 	{
 	public:
@@ -27,18 +64,52 @@ namespace NCL::CSC8508
 		 */
 		void InvokeOnAwake() { OnAwake(); }
 
+		/**
+		 * Function invoked each frame before Update.
+		 * @param deltaTime Time since last frame
+		 */
+		void InvokePreUpdate(float deltaTime) { PreUpdate(deltaTime); }
+
 		/**
 		 * Function invoked each frame.
 		 * @param deltaTime Time since last frame
 		 */
 		void InvokeUpdate(float deltaTime) { Update(deltaTime); }
 
+		/**
+		 * Function invoked each frame just before the physics system updates.
+		 * @param deltaTime Time since last frame
+		 */
+		void InvokePhysicsUpdate(float deltaTime) { PhysicsUpdate(deltaTime); }
+
 		/**
 		 * Function invoked each frame after Update.
 		 * @param deltaTime Time since last frame
 		 */
 		void InvokeLateUpdate(float deltaTime) { LateUpdate(deltaTime); }
 
+		/**
+		 * Function invoked each frame once everything else has updated, before the next frame is drawn.
+		 * @param deltaTime Time since last frame
+		 */
+		void InvokePreRender(float deltaTime) { PreRender(deltaTime); }
+
+		/**
+		 * Function invokes the hook for an update phase.
+		 * @param phase the phase to invoke
+		 * @param deltaTime Time since last frame
+		 */
+		void InvokePhase(UpdatePhases::Phase phase, float deltaTime) {
+			switch (phase) {
+				case UpdatePhases::PreUpdate:	PreUpdate(deltaTime);		break;
+				case UpdatePhases::Update:		Update(deltaTime);			break;
+				case UpdatePhases::PhysicsStep:	PhysicsUpdate(deltaTime);	break;
+				case UpdatePhases::LateUpdate:	LateUpdate(deltaTime);		break;
+				case UpdatePhases::PreRender:	PreRender(deltaTime);		break;
+				default: break;
+			}
+		}
+
 		/**
 		 * Function invoked when the component is enabled.
 		 */
@@ -54,6 +125,7 @@ namespace NCL::CSC8508
 		* @return the GameObject this component is attatched to.
 		*/
 		GameObject& GetGameObject();
+		const GameObject& GetGameObject() const;
 
 		/**
 		* Function Gets the enabled state of the component.
@@ -67,6 +139,13 @@ namespace NCL::CSC8508
 		*/
 		void SetEnabled(bool enabled);
 
+		/**
+		* Function gets the component's handle in the world's list for its type, for the types the world keeps a list of.
+		* @return the handle, which finds nothing once the component has left the world
+		*/
+		SlotHandle GetWorldHandle() const { return worldHandle; }
+		void SetWorldHandle(SlotHandle handle) { worldHandle = handle; }
+
 		/**
 		* Function gets the component type
 		* @return the component type
@@ -77,14 +156,43 @@ namespace NCL::CSC8508
 
 	protected:
 		virtual void OnAwake() {}
+		virtual void PreUpdate(float deltaTime) {}
 		virtual void Update(float deltaTime) {}
+		virtual void PhysicsUpdate(float deltaTime) {}
 		virtual void LateUpdate(float deltaTime) {}
+		virtual void PreRender(float deltaTime) {}
 		virtual void OnEnable() {}
 		virtual void OnDisable() {}
 
 	private:
 		GameObject& gameObject;
 		bool enabled;
+		SlotHandle worldHandle;
+	};
+
+	/**
+	 * Works out which of the update hooks a component type overrides, so the component is only put in the update
+	 * lists it has something to do in. Taking the address of a hook through a class derived from T gives a pointer
+	 * to a member of whichever class last declared it - IComponent itself if T never overrode it. Hooks have to be
+	 * public or protected for this to see them.
+	 */
+	template <typename T>
+	class ComponentHooks : public T
+	{
+	public:
+		static constexpr UpdatePhases::PhaseMask Overridden() {
+			return (Overrides(&ComponentHooks::PreUpdate)		? 1u << UpdatePhases::PreUpdate		: 0)
+				|  (Overrides(&ComponentHooks::Update)			? 1u << UpdatePhases::Update		: 0)
+				|  (Overrides(&ComponentHooks::PhysicsUpdate)	? 1u << UpdatePhases::PhysicsStep	: 0)
+				|  (Overrides(&ComponentHooks::LateUpdate)		? 1u << UpdatePhases::LateUpdate	: 0)
+				|  (Overrides(&ComponentHooks::PreRender)		? 1u << UpdatePhases::PreRender		: 0);
+		}
+
+	private:
+		static constexpr bool Overrides(void (IComponent::*)(float)) { return false; }
+
+		template <typename U>
+		static constexpr bool Overrides(void (U::*)(float)) { return true; }
 	};
 }
 
@@ -0,0 +1,165 @@
+#include "InterestManager.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace NCL;
+using namespace CSC8508;
+
+namespace {
+	const float DistanceWeight	= 3.0f;  //Priority gained a tick right next to a player, on top of 1 at the edge
+	const float KeepRange		= 1.25f; //Objects are only dropped once this far past the radius, so they don't flicker
+	const int	RecordHeaderBits = 14;	 //Roughly, for an ID step and the record flags
+	const int	RemovalBits		= 10;
+}
+
+InterestManager::InterestManager(float cellSize, float radius, int budgetBytes) {
+	this->cellSize		= cellSize;
+	this->radius		= radius;
+	this->budgetBytes	= budgetBytes;
+}
+
+InterestManager::~InterestManager() {
+}
+
+int64_t InterestManager::CellKey(int32_t x, int32_t z) const {
+	return ((int64_t)x << 32) | (uint32_t)z;
+}
+
+void InterestManager::BuildGrid(const Snapshot& world) {
+	if (cells.size() > world.entries.size() * 4 + 64) {
+		cells.clear(); //Too many cells nothing is in any more
+	}
+	for (auto& c : cells) {
+		c.second.clear();
+	}
+	float stepsPerCell = cellSize * SnapshotState::PositionScale;
+	for (int i = 0; i < (int)world.entries.size(); ++i) {
+		const int32_t* p = world.entries[i].state.position;
+		cells[CellKey((int32_t)std::floor(p[0] / stepsPerCell), (int32_t)std::floor(p[2] / stepsPerCell))].push_back(i);
+	}
+}
+
+//Fills relevant with every object within range of the focus, in network ID order
+void InterestManager::GatherRelevant(const Vector3* focus, const Snapshot& world, float range) {
+	relevant.clear();
+	if (!focus) {
+		for (int i = 0; i < (int)world.entries.size(); ++i) {
+			relevant.push_back({ i, 0.0f, 0.0f });
+		}
+		return;
+	}
+	int32_t minX = (int32_t)std::floor((focus->x - range) / cellSize);
+	int32_t maxX = (int32_t)std::floor((focus->x + range) / cellSize);
+	int32_t minZ = (int32_t)std::floor((focus->z - range) / cellSize);
+	int32_t maxZ = (int32_t)std::floor((focus->z + range) / cellSize);
+
+	for (int32_t x = minX; x <= maxX; ++x) {
+		for (int32_t z = minZ; z <= maxZ; ++z) {
+			auto c = cells.find(CellKey(x, z));
+			if (c == cells.end()) {
+				continue;
+			}
+			for (int i : c->second) {
+				Vector3 offset	= world.entries[i].state.GetPosition() - *focus;
+				float distance	= Vector::Length(offset);
+				if (distance <= range) {
+					relevant.push_back({ i, distance, 0.0f });
+				}
+			}
+		}
+	}
+	std::sort(relevant.begin(), relevant.end(), [](const Candidate& a, const Candidate& b) { return a.entry < b.entry; });
+}
+
+/*
+The player's view starts as a copy of what they acknowledged. Objects that
+have gone, or wandered out of range, are dropped from it, then changed objects
+are copied in from the world, highest priority first, until the budget runs
+out. The view is then written out as a delta against what they acknowledged,
+which comes out as exactly the changes that were picked.
+*/
+int InterestManager::WritePlayerSnapshot(int playerID, const Vector3* focus, const Snapshot& world, int ackedID, std::vector<SnapshotPacket>& packets) {
+	PlayerInterest& player = players[playerID];
+
+	//An ack a whole buffer old would share a slot with the view about to be written
+	const Snapshot* baseline = (world.id - ackedID < SnapshotBuffer::Size) ? player.sent.Find(ackedID) : nullptr;
+	Snapshot& view = player.sent.Add(world.id);
+	view.time = world.time;
+	if (baseline) {
+		view.entries = baseline->entries;
+	}
+
+	GatherRelevant(focus, world, focus ? radius * KeepRange : radius);
+
+	//Both are in network ID order, so can be walked side by side
+	int spentBits	= 0;
+	size_t kept		= 0;
+	size_t r		= 0;
+	for (size_t i = 0; i < view.entries.size(); ++i) {
+		int networkID = view.entries[i].networkID;
+		while (r < relevant.size() && world.entries[relevant[r].entry].networkID < networkID) {
+			r++;
+		}
+		if (r < relevant.size() && world.entries[relevant[r].entry].networkID == networkID) {
+			view.entries[kept++] = view.entries[i];
+		}
+		else {
+			player.priorities.erase(networkID);
+			spentBits += RemovalBits;
+		}
+	}
+	view.entries.resize(kept);
+
+	candidates.clear();
+	for (const Candidate& c : relevant) {
+		const SnapshotEntry& e		= world.entries[c.entry];
+		const SnapshotState* held	= view.Find(e.networkID);
+		if (!held && c.distance > radius) {
+			continue; //Not close enough to start sending yet
+		}
+		if (held && *held == e.state) {
+			player.priorities.erase(e.networkID);
+			continue;
+		}
+		float nearness = focus ? std::max(0.0f, 1.0f - c.distance / radius) : 1.0f;
+		float& priority = player.priorities[e.networkID];
+		priority += 1.0f + DistanceWeight * nearness;
+		candidates.push_back({ c.entry, c.distance, priority });
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.priority > b.priority; });
+
+	char scratch[32];
+	int budgetBits = budgetBytes * 8;
+	for (const Candidate& c : candidates) {
+		const SnapshotEntry& e = world.entries[c.entry];
+		auto held = std::lower_bound(view.entries.begin(), view.entries.end(), e,
+			[](const SnapshotEntry& a, const SnapshotEntry& b) { return a.networkID < b.networkID; });
+		bool found = held != view.entries.end() && held->networkID == e.networkID;
+
+		BitWriter sizer(scratch, sizeof(scratch));
+		if (found) {
+			e.state.WriteFields(sizer, e.state.ChangedFields(held->state), &held->state);
+		}
+		else {
+			e.state.WriteFields(sizer, SnapshotState::AllFields, nullptr);
+		}
+		int bits = RecordHeaderBits + sizer.GetBitPosition();
+		if (spentBits + bits > budgetBits) {
+			continue; //Something smaller further down might still fit
+		}
+		spentBits += bits;
+
+		if (found) {
+			held->state = e.state;
+		}
+		else {
+			view.entries.insert(held, e);
+		}
+		player.priorities.erase(e.networkID);
+	}
+	return view.WriteDelta(baseline, packets);
+}
+
+void InterestManager::RemovePlayer(int playerID) {
+	players.erase(playerID);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "NetworkSnapshot.h"
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Decides what each player gets sent. Objects are bucketed into a grid on
+		the ground plane each tick, so finding those near a player only looks at
+		a few cells, however big the map. Each nearby object builds up priority
+		every tick it isn't sent - faster the closer it is - and each tick the
+		highest go out until the player's byte budget is spent.
+
+		As a player can be left behind on some objects, the server can't assume
+		they hold the same world as everyone else, so their own copy of every
+		snapshot they've been sent is kept, to delta against once they ack it.
+		*/
+		class InterestManager {
+		public:
+			InterestManager(float cellSize = 32.0f, float radius = 160.0f, int budgetBytes = 2 * SnapshotPacket::MaxData);
+			~InterestManager();
+
+			void SetRadius(float r) {
+				radius = r;
+			}
+			void SetBudget(int bytesPerTick) {
+				budgetBytes = bytesPerTick;
+			}
+
+			//Buckets every object in this tick's snapshot by grid cell
+			void BuildGrid(const Snapshot& world);
+
+			/*
+			Picks what this player is sent this tick, against the last snapshot
+			they acknowledged, and writes it into packets. Without a focus,
+			every object is relevant, and only the budget limits what's sent.
+			Returns the number of packets used.
+			*/
+			int WritePlayerSnapshot(int playerID, const Vector3* focus, const Snapshot& world, int ackedID, std::vector<SnapshotPacket>& packets);
+
+			void RemovePlayer(int playerID);
+
+		protected:
+			struct Candidate {
+				int		entry;		//Into the world snapshot
+				float	distance;
+				float	priority;
+			};
+
+			struct PlayerInterest {
+				SnapshotBuffer sent;
+				std::unordered_map<int, float> priorities; //By network ID
+			};
+
+			int64_t CellKey(int32_t x, int32_t z) const;
+			void GatherRelevant(const Vector3* focus, const Snapshot& world, float range);
+
+			float	cellSize;
+			float	radius;
+			int		budgetBytes;
+
+			std::unordered_map<int64_t, std::vector<int>> cells;
+			std::unordered_map<int, PlayerInterest> players;
+
+			//Reused every call
+			std::vector<Candidate>	relevant;
+			std::vector<Candidate>	candidates;
+		};
+	}
+}
@@ -0,0 +1,78 @@
+#include "InterpolationBuffer.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8508;
+
+void InterpolationBuffer::Add(float time, const Vector3& position, const Quaternion& orientation) {
+	if (count > 0) {
+		float latest = At(count - 1).time;
+		if (time <= latest) {
+			return;
+		}
+		if (time - latest > MaxGap) {
+			Clear(); //Out of sight for a while - start again from here, rather than sliding in from the old state
+		}
+	}
+	if (count == Capacity) {
+		start = (start + 1) % Capacity;
+		count--;
+	}
+	states[(start + count) % Capacity] = { time, position, orientation };
+	count++;
+}
+
+//Central difference where there's a state either side, one sided at the ends
+Vector3 InterpolationBuffer::VelocityAt(int i) const {
+	int before	= std::max(i - 1, 0);
+	int after	= std::min(i + 1, count - 1);
+	if (before == after) {
+		return Vector3();
+	}
+	const State& a = At(before);
+	const State& b = At(after);
+	return (b.position - a.position) / (b.time - a.time);
+}
+
+bool InterpolationBuffer::Sample(float time, float maxExtrapolation, Vector3& position, Quaternion& orientation) const {
+	if (count == 0) {
+		return false;
+	}
+	const State& first = At(0);
+	if (count == 1 || time <= first.time) {
+		position	= first.position;
+		orientation = first.orientation;
+		return true;
+	}
+
+	const State& last = At(count - 1);
+	if (time >= last.time) {
+		float ahead = std::min(time - last.time, maxExtrapolation);
+		position	= last.position + VelocityAt(count - 1) * ahead;
+		orientation = last.orientation;
+		return true;
+	}
+
+	//The time shown is nearly always close to the newest states, so search back from there
+	int i = count - 2;
+	while (i > 0 && At(i).time > time) {
+		--i;
+	}
+	const State& a = At(i);
+	const State& b = At(i + 1);
+
+	float span	= b.time - a.time;
+	float t		= (time - a.time) / span;
+	float t2	= t * t;
+	float t3	= t2 * t;
+
+	float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+	float h10 = t3 - 2.0f * t2 + t;
+	float h01 = -2.0f * t3 + 3.0f * t2;
+	float h11 = t3 - t2;
+
+	position = a.position * h00 + VelocityAt(i) * (span * h10)
+			 + b.position * h01 + VelocityAt(i + 1) * (span * h11);
+	orientation = Quaternion::Slerp(a.orientation, b.orientation, t);
+	return true;
+}
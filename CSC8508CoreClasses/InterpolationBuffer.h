@@ -0,0 +1,60 @@
+#pragma once
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8508 {
+		/*
+		The last few states received for a remote object, each stamped with the
+		server time it was taken at. The client shows objects a little in the
+		past, so there's almost always a state either side of the time being
+		shown, and can smoothly curve between them rather than snapping from
+		one to the next as they arrive.
+
+		Positions follow a cubic Hermite curve, with each state's velocity taken
+		from the states either side of it, and orientations are slerped. If the
+		states stop coming, the object carries on at its last velocity, but
+		only for so long before it stops where it was headed.
+		*/
+		class InterpolationBuffer {
+		public:
+			static constexpr int	Capacity	= 32;
+			static constexpr float	MaxGap		= 1.0f; //States further apart than this aren't curved between
+
+			InterpolationBuffer() {
+				Clear();
+			}
+
+			//States older than the newest are dropped, as they arrived out of order
+			void Add(float time, const Vector3& position, const Quaternion& orientation);
+
+			//Returns false if there's nothing to sample yet
+			bool Sample(float time, float maxExtrapolation, Vector3& position, Quaternion& orientation) const;
+
+			void Clear() {
+				start = 0;
+				count = 0;
+			}
+
+			int GetCount() const {
+				return count;
+			}
+
+		protected:
+			struct State {
+				float		time;
+				Vector3		position;
+				Quaternion	orientation;
+			};
+
+			const State& At(int i) const {
+				return states[(start + i) % Capacity];
+			}
+
+			Vector3 VelocityAt(int i) const;
+
+			State	states[Capacity];
+			int		start;
+			int		count;
+		};
+	}
+}
@@ -0,0 +1,153 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8508;
+
+//Which queue the current thread owns - threads outside the system all share queue 0
+static thread_local int ownQueue = 0;
+
+static unsigned int WorkerCount(unsigned int threadCount) {
+	if (threadCount == 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 0;
+	}
+	return threadCount;
+}
+
+JobSystem::JobSystem(unsigned int threadCount) : queues(WorkerCount(threadCount) + 1) {
+	queuedJobs	= 0;
+	quitting	= false;
+
+	for (int i = 1; i < (int)queues.size(); ++i) {
+		threads.emplace_back(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		quitting = true;
+	}
+	workReady.notify_all();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+void JobSystem::JobQueue::Push(Job&& job) {
+	std::lock_guard<std::mutex> lock(mutex);
+	jobs.push_back(std::move(job));
+}
+
+bool JobSystem::JobQueue::Pop(Job& job) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (jobs.empty()) {
+		return false;
+	}
+	job = std::move(jobs.back());
+	jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::JobQueue::Steal(Job& job) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (jobs.empty()) {
+		return false;
+	}
+	job = std::move(jobs.front());
+	jobs.pop_front();
+	return true;
+}
+
+int JobSystem::GetQueueIndex() const {
+	return ownQueue;
+}
+
+void JobSystem::Run(JobFunc job, JobCounter* counter, const JobCounter* dependency) {
+	if (counter) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (threads.empty()) {
+		Job j = { std::move(job), counter, dependency };
+		Execute(j);
+		return;
+	}
+	queues[GetQueueIndex()].Push({ std::move(job), counter, dependency });
+	{
+		//Taking the lock means a worker can't miss this between checking for work and going to sleep
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedJobs++;
+	}
+	workReady.notify_one();
+}
+
+void JobSystem::Wait(const JobCounter& counter) {
+	int queueIndex = GetQueueIndex();
+	while (!counter.IsDone()) {
+		if (!RunNextJob(queueIndex)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(int count, int grainSize, const RangeFunc& func) {
+	if (count <= 0) {
+		return;
+	}
+	grainSize = std::max(grainSize, 1);
+	if (threads.empty() || count <= grainSize) {
+		func(0, count);
+		return;
+	}
+	JobCounter counter;
+	for (int begin = grainSize; begin < count; begin += grainSize) {
+		int end = std::min(begin + grainSize, count);
+		Run([&func, begin, end] { func(begin, end); }, &counter);
+	}
+	func(0, grainSize);
+	Wait(counter);
+}
+
+/*
+Own work comes first, newest first. Only once that runs out does the thread
+look through the other queues, oldest first, starting with its neighbour so
+that idle threads don't all go for the same queue.
+*/
+bool JobSystem::RunNextJob(int queueIndex) {
+	Job job;
+	bool found = queues[queueIndex].Pop(job);
+	for (int i = 1; !found && i < (int)queues.size(); ++i) {
+		found = queues[(queueIndex + i) % queues.size()].Steal(job);
+	}
+	if (!found) {
+		return false;
+	}
+	queuedJobs--;
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Execute(Job& job) {
+	if (job.dependency) {
+		Wait(*job.dependency);
+	}
+	job.func();
+	if (job.counter) {
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void JobSystem::WorkerMain(int queueIndex) {
+	ownQueue = queueIndex;
+	while (true) {
+		if (RunNextJob(queueIndex)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		workReady.wait(lock, [&] { return quitting || queuedJobs > 0; });
+		if (quitting) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <deque>
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Counts the jobs that are still to finish. Jobs are added to a counter when
+		they're submitted, and taken off once they've run, so waiting for a counter
+		waits for every job submitted against it.
+		*/
+		class JobCounter {
+		public:
+			JobCounter() {
+				pending = 0;
+			}
+
+			JobCounter(const JobCounter&) = delete;
+			JobCounter& operator=(const JobCounter&) = delete;
+
+			bool IsDone() const {
+				return pending.load(std::memory_order_acquire) == 0;
+			}
+
+		protected:
+			friend class JobSystem;
+			std::atomic<int> pending;
+		};
+
+		/*
+		Runs jobs across a fixed set of threads, started once and shared by the
+		whole frame. Every thread has its own queue: a thread pushes and pops the
+		jobs it makes at the back of its own queue, where they're still warm in
+		its cache, and a thread that runs out of work steals from the front of
+		someone else's. Threads outside the system, such as the main thread, share
+		one more queue.
+
+		A thread that waits on a counter keeps running jobs until the counter is
+		done, rather than blocking, so jobs can safely wait on other jobs.
+		*/
+		class JobSystem {
+		public:
+			typedef std::function<void()> JobFunc;
+			typedef std::function<void(int, int)> RangeFunc;
+
+			static JobSystem& Instance() {
+				static JobSystem instance;
+				return instance;
+			}
+
+			JobSystem(const JobSystem&) = delete;
+			JobSystem& operator=(const JobSystem&) = delete;
+
+			/*
+			Queues a job, adding it to the counter if there is one. A job with a
+			dependency won't start until every job on that counter has finished.
+			*/
+			void Run(JobFunc job, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr);
+
+			//Runs other jobs until every job on the counter has finished
+			void Wait(const JobCounter& counter);
+
+			/*
+			Splits [0, count) into ranges of at most grainSize, and calls func(begin, end)
+			on each of them across the threads. Returns once every range is done. Ranges
+			may run in any order, on any thread, so func must only write to its own
+			part of any output.
+			*/
+			void ParallelFor(int count, int grainSize, const RangeFunc& func);
+
+			unsigned int GetThreadCount() const {
+				return (unsigned int)threads.size() + 1;
+			}
+
+		protected:
+			JobSystem(unsigned int threadCount = 0); //0 uses one less than the number of cores
+			~JobSystem();
+
+			struct Job {
+				JobFunc				func;
+				JobCounter*			counter;
+				const JobCounter*	dependency;
+			};
+
+			class JobQueue {
+			public:
+				void Push(Job&& job);
+				bool Pop(Job& job);
+				bool Steal(Job& job);
+			protected:
+				std::mutex		mutex;
+				std::deque<Job> jobs;
+			};
+
+			int  GetQueueIndex() const;
+			bool RunNextJob(int queueIndex);
+			void Execute(Job& job);
+			void WorkerMain(int queueIndex);
+
+			std::vector<std::thread>	threads;
+			std::vector<JobQueue>		queues; //The shared queue first, then one for each worker
+
+			std::mutex				sleepMutex;
+			std::condition_variable	workReady;
+			std::atomic<int>		queuedJobs;
+			bool					quitting;
+		};
+	}
+}
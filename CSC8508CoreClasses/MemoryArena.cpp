@@ -0,0 +1,47 @@
+#include "MemoryArena.h"
+#include <new>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8508;
+
+MemoryArena::MemoryArena(size_t blockSize) {
+	this->blockSize	= blockSize;
+	offset			= 0;
+	used			= 0;
+}
+
+MemoryArena::~MemoryArena() {
+	for (Block& b : blocks) {
+		::operator delete(b.data);
+	}
+}
+
+void MemoryArena::AddBlock(size_t minSize) {
+	size_t size = std::max(blockSize, minSize);
+	blocks.push_back({ (unsigned char*)::operator new(size), size });
+	offset = 0;
+}
+
+//::operator new gives back blocks aligned for anything, so only the offset needs rounding up
+void* MemoryArena::Allocate(size_t size, size_t alignment) {
+	size_t start = (offset + alignment - 1) & ~(alignment - 1);
+	if (blocks.empty() || start + size > blocks.back().size) {
+		AddBlock(size);
+		start = 0;
+	}
+	offset	= start + size;
+	used	+= size;
+	return blocks.back().data + start;
+}
+
+void MemoryArena::Reset() {
+	for (size_t i = 1; i < blocks.size(); ++i) {
+		::operator delete(blocks[i].data);
+	}
+	if (blocks.size() > 1) {
+		blocks.resize(1);
+	}
+	offset	= 0;
+	used	= 0;
+}
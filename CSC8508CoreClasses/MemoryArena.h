@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Hands out memory by bumping an offset through large blocks, so many small
+		allocations cost about as much as one. Nothing is freed on its own - the
+		whole arena is dropped at once with Reset, which keeps the first block
+		around to fill again. Whatever was made in the arena must have been
+		destroyed by then.
+		*/
+		class MemoryArena {
+		public:
+			MemoryArena(size_t blockSize = 64 * 1024);
+			~MemoryArena();
+
+			MemoryArena(const MemoryArena&) = delete;
+			MemoryArena& operator=(const MemoryArena&) = delete;
+
+			void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+			void Reset();
+
+			//Bytes handed out since the last Reset
+			size_t GetUsed() const {
+				return used;
+			}
+
+		protected:
+			struct Block {
+				unsigned char*	data;
+				size_t			size;
+			};
+
+			void AddBlock(size_t minSize);
+
+			std::vector<Block> blocks;
+			size_t blockSize;
+			size_t offset; //Into the last block
+			size_t used;
+		};
+	}
+}
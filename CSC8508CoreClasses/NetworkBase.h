@@ -15,7 +15,8 @@ enum BasicNetworkMessages {
 	Player_Connected,
 	Player_Disconnected,
 	Acknowledge_State,
-	Shutdown
+	Shutdown,
+	Snapshot_State	//Every object that changed since the snapshot a client last acknowledged
 };
 
 
@@ -43,7 +44,7 @@ struct AcknowledgePacket : public GamePacket {
 
 	AcknowledgePacket(int stateID) {
 		type = Received_State; 
-		size = sizeof(AcknowledgePacket); 
+		size = sizeof(AcknowledgePacket) - sizeof(GamePacket);
 		this->stateID = stateID;
 	}
 
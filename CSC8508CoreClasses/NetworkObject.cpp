@@ -24,38 +24,32 @@ bool NetworkObject::WritePacket(GamePacket** p, bool deltaFrame, int stateID) {
 bool NetworkObject::WriteFullPacket(GamePacket** p) {
 	FullPacket* fp = new FullPacket();
 
-	fp->objectID = networkID;
-	fp->fullState.position = object.GetTransform().GetPosition();
-	fp->fullState.orientation = object.GetTransform().GetOrientation();
-	fp->fullState.stateID = lastFullState.stateID++;
+	BitWriter writer(fp->data, FullPacket::MaxData);
+	writer.WriteVarInt(networkID);
+	writer.WriteVarInt(lastFullState.stateID++);
+	GetSnapshotState().WriteFields(writer, SnapshotState::AllFields, nullptr);
+	fp->size = writer.GetBytesWritten();
 	*p = fp;
 	return true;
 }
 
 bool NetworkObject::WriteDeltaPacket(GamePacket** p, int stateID) {
-	DeltaPacket* dp = new DeltaPacket();
 	NetworkState state;
 	if (!GetNetworkState(stateID, state)) {
 		return false; // can't delta!
 	}
 
-	dp->fullID = stateID;
-	dp->objectID = networkID;
-
-	Vector3 currentPos = object.GetTransform().GetPosition();
-	Quaternion currentOrientation = object.GetTransform().GetOrientation();
-
-	currentPos -= state.position;
-	currentOrientation -= state.orientation;
+	SnapshotState current	= GetSnapshotState();
+	SnapshotState from		= SnapshotState::Quantise(state.position, state.orientation);
+	uint8_t fields			= current.ChangedFields(from);
 
-	dp->pos[0] = (char)currentPos.x;
-	dp->pos[1] = (char)currentPos.y;
-	dp->pos[2] = (char)currentPos.z;
-
-	dp->orientation[0] = (char)(currentOrientation.x * 127.0f);
-	dp->orientation[1] = (char)(currentOrientation.y * 127.0f);
-	dp->orientation[2] = (char)(currentOrientation.z * 127.0f);
-	dp->orientation[3] = (char)(currentOrientation.w * 127.0f);
+	DeltaPacket* dp = new DeltaPacket();
+	BitWriter writer(dp->data, DeltaPacket::MaxData);
+	writer.WriteVarInt(networkID);
+	writer.WriteVarInt(stateID);
+	writer.WriteBits(fields, 4);
+	current.WriteFields(writer, fields, &from);
+	dp->size = writer.GetBytesWritten();
 	*p = dp;
 	return true;
 }
@@ -69,37 +63,47 @@ bool NetworkObject::ReadPacket(GamePacket& p) {
 }
 
 bool NetworkObject::ReadDeltaPacket(DeltaPacket& p) {
-	if (p.fullID != lastFullState.stateID) 
+	if (p.size < 0 || p.size > DeltaPacket::MaxData) 
+		return false;
+
+	BitReader reader(p.data, p.size);
+	uint32_t objectID, fullID, fields;
+	if (!reader.ReadVarInt(objectID) || objectID != (uint32_t)networkID) 
+		return false; // for another object
+	if (!reader.ReadVarInt(fullID) || (int)fullID != lastFullState.stateID || !reader.ReadBits(fields, 4)) 
 		return false; 
 
-	UpdateStateHistory(p.fullID);
+	UpdateStateHistory((int)fullID);
 
-	Vector3 fullPos = lastFullState.position;
-	Quaternion fullOrientation = lastFullState.orientation;
+	SnapshotState state = SnapshotState::Quantise(lastFullState.position, lastFullState.orientation);
+	if (!state.ReadFields(reader, (uint8_t)fields, true)) 
+		return false;
 
-	fullPos.x += p.pos[0];
-	fullPos.y += p.pos[1];
-	fullPos.z += p.pos[2];
-
-	fullOrientation.x += ((float)p.orientation[0]) / 127.0f;
-	fullOrientation.y += ((float)p.orientation[1]) / 127.0f;
-	fullOrientation.z += ((float)p.orientation[2]) / 127.0f;
-	fullOrientation.w += ((float)p.orientation[3]) / 127.0f;
-
-	object.GetTransform().SetPosition(fullPos);
-	object.GetTransform().SetOrientation(fullOrientation);
+	ApplySnapshotState(state);
 	return true;
 }
 
 bool NetworkObject::ReadFullPacket(FullPacket& p) 
 {
-	if (p.fullState.stateID < lastFullState.stateID) 
+	if (p.size < 0 || p.size > FullPacket::MaxData) 
+		return false;
+
+	BitReader reader(p.data, p.size);
+	uint32_t objectID, stateID;
+	if (!reader.ReadVarInt(objectID) || objectID != (uint32_t)networkID) 
+		return false; // for another object
+	if (!reader.ReadVarInt(stateID) || (int)stateID < lastFullState.stateID) 
 		return false; 
 
-	lastFullState = p.fullState;
+	SnapshotState state;
+	if (!state.ReadFields(reader, SnapshotState::AllFields, false)) 
+		return false;
 
-	object.GetTransform().SetPosition(lastFullState.position);
-	object.GetTransform().SetOrientation(lastFullState.orientation);
+	lastFullState.position		= state.GetPosition();
+	lastFullState.orientation	= state.GetOrientation();
+	lastFullState.stateID		= (int)stateID;
+
+	ApplySnapshotState(state);
 
 	stateHistory.emplace_back(lastFullState);
 	return true;
@@ -127,3 +131,25 @@ bool NetworkObject::GetNetworkState(int stateID, NetworkState& state) {
 	}
 	return false;
 }
+
+SnapshotState NetworkObject::GetSnapshotState() const {
+	return SnapshotState::Quantise(object.GetTransform().GetPosition(), object.GetTransform().GetOrientation());
+}
+
+void NetworkObject::ApplySnapshotState(const SnapshotState& state) {
+	object.GetTransform().SetPosition(state.GetPosition());
+	object.GetTransform().SetOrientation(state.GetOrientation());
+}
+
+void NetworkObject::ReceiveSnapshotState(const SnapshotState& state, float serverTime) {
+	interpolation.Add(serverTime, state.GetPosition(), state.GetOrientation());
+}
+
+void NetworkObject::UpdateInterpolation(float serverTime, float maxExtrapolation) {
+	Vector3 position;
+	Quaternion orientation;
+	if (interpolation.Sample(serverTime, maxExtrapolation, position, orientation)) {
+		object.GetTransform().SetPosition(position);
+		object.GetTransform().SetOrientation(orientation);
+	}
+}
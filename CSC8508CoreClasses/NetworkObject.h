@@ -2,29 +2,36 @@
 #include "GameObject.h"
 #include "NetworkBase.h"
 #include "NetworkState.h"
+#include "NetworkSnapshot.h"
+#include "InterpolationBuffer.h"
 
 namespace NCL::CSC8508 {
 	class GameObject;
 
+	/*
+	States are bit packed into the data, and only the bytes written are sent,
+	so what goes over the wire doesn't depend on how a compiler lays out the
+	packet. A full packet holds the object ID, the state ID, then the whole
+	state.
+	*/
 	struct FullPacket : public GamePacket {
-		int		objectID = -1;
-		NetworkState fullState;
+		static constexpr int MaxData = 24;
+		char	data[MaxData];
 
 		FullPacket() {
 			type = Full_State;
-			size = sizeof(FullPacket) - sizeof(GamePacket);
+			size = 0;
 		}
 	};
 
+	//The object ID, the ID of the full state it's against, which fields changed, then the changes
 	struct DeltaPacket : public GamePacket {
-		int		fullID		= -1;
-		int		objectID	= -1;
-		char	pos[3];
-		char	orientation[4];
+		static constexpr int MaxData = 24;
+		char	data[MaxData];
 
 		DeltaPacket() {
 			type = Delta_State;
-			size = sizeof(DeltaPacket) - sizeof(GamePacket);
+			size = 0;
 		}
 	};
 
@@ -33,7 +40,7 @@ namespace NCL::CSC8508 {
 		float score;
 
 		ClientPacket() {
-			size = sizeof(ClientPacket);
+			size = sizeof(ClientPacket) - sizeof(GamePacket);
 		}
 	};
 
@@ -47,6 +54,15 @@ namespace NCL::CSC8508 {
 		int GetNetworkID() { return networkID; }
 		void UpdateStateHistory(int minID);
 
+		virtual SnapshotState GetSnapshotState() const;
+		virtual void ApplySnapshotState(const SnapshotState& state);
+
+		//Keeps a state from the server, to be shown once the client's clock catches up with it
+		void ReceiveSnapshotState(const SnapshotState& state, float serverTime);
+
+		//Moves the object to where it was at the given server time
+		void UpdateInterpolation(float serverTime, float maxExtrapolation);
+
 	protected:
 
 		NetworkState& GetLatestNetworkState();
@@ -62,6 +78,7 @@ namespace NCL::CSC8508 {
 		GameObject& object;
 		NetworkState lastFullState;
 		std::vector<NetworkState> stateHistory;
+		InterpolationBuffer interpolation;
 
 		int deltaErrors;
 		int fullErrors;
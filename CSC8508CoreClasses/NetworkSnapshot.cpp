@@ -0,0 +1,262 @@
+#include "NetworkSnapshot.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace NCL;
+using namespace CSC8508;
+
+namespace {
+	const int IDGroupBits = 4; //IDs mostly step up by a little at a time
+
+	bool SortByID(const SnapshotEntry& a, const SnapshotEntry& b) {
+		return a.networkID < b.networkID;
+	}
+
+	bool EntryBeforeID(const SnapshotEntry& e, int networkID) {
+		return e.networkID < networkID;
+	}
+
+	uint32_t ZigZag(int32_t v) {
+		return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+	}
+
+	int32_t UnZigZag(uint32_t v) {
+		return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+	}
+}
+
+SnapshotState SnapshotState::Quantise(const Vector3& position, const Quaternion& orientation) {
+	SnapshotState s;
+	for (int i = 0; i < 3; ++i) {
+		float steps = std::clamp(position[i] * PositionScale, (float)-PositionLimit, (float)PositionLimit);
+		s.position[i] = (int32_t)std::lround(steps);
+	}
+	s.orientation = SmallestThree::Compress(orientation, OrientationBits);
+	return s;
+}
+
+Vector3 SnapshotState::GetPosition() const {
+	return Vector3(position[0], position[1], position[2]) / PositionScale;
+}
+
+Quaternion SnapshotState::GetOrientation() const {
+	return orientation.Decompress(OrientationBits);
+}
+
+uint8_t SnapshotState::ChangedFields(const SnapshotState& from) const {
+	uint8_t fields = 0;
+	for (int i = 0; i < 3; ++i) {
+		if (position[i] != from.position[i]) {
+			fields |= PositionX << i;
+		}
+	}
+	if (orientation != from.orientation) {
+		fields |= Orientation;
+	}
+	return fields;
+}
+
+/*
+A changed axis is a bit saying if the change was small, then either the small
+change or the whole value. Orientations are always sent whole, as smallest
+three form is already about as small as a change would be.
+*/
+void SnapshotState::WriteFields(BitWriter& writer, uint8_t fields, const SnapshotState* from) const {
+	const int32_t smallLimit = 1 << (SmallDeltaBits - 1);
+	for (int i = 0; i < 3; ++i) {
+		if (!(fields & (PositionX << i))) {
+			continue;
+		}
+		if (from) {
+			int32_t delta = position[i] - from->position[i];
+			bool small = delta >= -smallLimit && delta < smallLimit;
+			writer.WriteBool(small);
+			if (small) {
+				writer.WriteBoundedInt(delta, -smallLimit, smallLimit - 1);
+				continue;
+			}
+		}
+		writer.WriteBoundedInt(position[i], -PositionLimit, PositionLimit);
+	}
+	if (fields & Orientation) {
+		writer.WriteSmallestThree(orientation, OrientationBits);
+	}
+}
+
+bool SnapshotState::ReadFields(BitReader& reader, uint8_t fields, bool changes) {
+	const int32_t smallLimit = 1 << (SmallDeltaBits - 1);
+	for (int i = 0; i < 3; ++i) {
+		if (!(fields & (PositionX << i))) {
+			continue;
+		}
+		bool small = false;
+		if (changes && !reader.ReadBool(small)) {
+			return false;
+		}
+		if (small) {
+			int32_t delta;
+			if (!reader.ReadBoundedInt(delta, -smallLimit, smallLimit - 1)) {
+				return false;
+			}
+			position[i] += delta;
+		}
+		else if (!reader.ReadBoundedInt(position[i], -PositionLimit, PositionLimit)) {
+			return false;
+		}
+	}
+	if (fields & Orientation) {
+		return reader.ReadSmallestThree(orientation, OrientationBits);
+	}
+	return true;
+}
+
+void Snapshot::Add(int networkID, const SnapshotState& state) {
+	entries.push_back({ networkID, state });
+}
+
+void Snapshot::Sort() {
+	std::sort(entries.begin(), entries.end(), SortByID);
+}
+
+const SnapshotState* Snapshot::Find(int networkID) const {
+	auto i = std::lower_bound(entries.begin(), entries.end(), networkID, EntryBeforeID);
+	return (i != entries.end() && i->networkID == networkID) ? &i->state : nullptr;
+}
+
+/*
+Each object written is its network ID, as a step up from the last one in the
+same packet, then a bit saying if it has been removed. If not, a bit saying if
+it is sent whole, and if it isn't, which of its fields follow.
+
+If a record won't fit in the space left in a packet, the writer is rewound to
+before it, and it is written again at the start of the next one.
+*/
+int Snapshot::WriteDelta(const Snapshot* baseline, std::vector<SnapshotPacket>& packets) const {
+	int parts	= 0;
+	int lastID	= 0;
+	SnapshotPacket* packet = nullptr;
+	BitWriter writer(nullptr, 0);
+
+	auto beginPacket = [&]() {
+		if (parts == (int)packets.size()) {
+			packets.emplace_back();
+		}
+		packet = &packets[parts++];
+		packet->snapshotID	= id;
+		packet->baselineID	= baseline ? baseline->id : -1;
+		packet->serverTime	= time;
+		packet->objectCount = 0;
+		writer = BitWriter(packet->data, SnapshotPacket::MaxData);
+		lastID = 0;
+	};
+
+	auto writeRecord = [&](int networkID, uint8_t fields, bool removed, const SnapshotState* from, const SnapshotState* to) {
+		for (int attempt = 0; attempt < 2; ++attempt) {
+			int start = writer.GetBitPosition();
+			writer.WriteVarInt(ZigZag(networkID - lastID), IDGroupBits);
+			writer.WriteBool(removed);
+			if (!removed) {
+				writer.WriteBool(from == nullptr);
+				if (from) {
+					writer.WriteBits(fields, 4);
+				}
+				to->WriteFields(writer, fields, from);
+			}
+			if (!writer.HasOverflowed()) {
+				break;
+			}
+			writer.Rewind(start);
+			packet->SetDataSize(writer.GetBytesWritten());
+			beginPacket(); //ID steps start again in a new packet, so the record is rewritten
+		}
+		packet->objectCount++;
+		lastID = networkID;
+	};
+
+	beginPacket();
+
+	size_t b = 0;
+	size_t baselineCount = baseline ? baseline->entries.size() : 0;
+	for (const SnapshotEntry& e : entries) {
+		for (; b < baselineCount && baseline->entries[b].networkID < e.networkID; ++b) {
+			writeRecord(baseline->entries[b].networkID, 0, true, nullptr, nullptr);
+		}
+		const SnapshotState* from = nullptr;
+		if (b < baselineCount && baseline->entries[b].networkID == e.networkID) {
+			from = &baseline->entries[b++].state;
+		}
+		uint8_t fields = from ? e.state.ChangedFields(*from) : (uint8_t)SnapshotState::AllFields;
+		if (fields != 0) {
+			writeRecord(e.networkID, fields, false, from, &e.state);
+		}
+	}
+	for (; b < baselineCount; ++b) {
+		writeRecord(baseline->entries[b].networkID, 0, true, nullptr, nullptr);
+	}
+	packet->SetDataSize(writer.GetBytesWritten());
+
+	if (parts > SnapshotPacket::MaxParts) {
+		return 0;
+	}
+	for (int i = 0; i < parts; ++i) {
+		packets[i].partIndex = (unsigned char)i;
+		packets[i].partCount = (unsigned char)parts;
+	}
+	return parts;
+}
+
+bool Snapshot::BeginDelta(const Snapshot* baseline, const SnapshotPacket& packet) {
+	if (packet.baselineID >= 0 && (!baseline || baseline->id != packet.baselineID)) {
+		return false; //Can't rebuild a delta without what it was taken against
+	}
+	if (packet.baselineID >= 0) {
+		entries = baseline->entries;
+	}
+	else {
+		entries.clear();
+	}
+	id		= packet.snapshotID;
+	time	= packet.serverTime;
+	return true;
+}
+
+bool Snapshot::ReadDeltaPart(const SnapshotPacket& packet) {
+	if (packet.snapshotID != id || packet.dataSize < 0 || packet.dataSize > SnapshotPacket::MaxData) {
+		return false;
+	}
+	BitReader reader(packet.data, packet.dataSize);
+	int networkID = 0;
+	for (int i = 0; i < packet.objectCount; ++i) {
+		uint32_t idStep;
+		bool removed;
+		if (!reader.ReadVarInt(idStep, IDGroupBits) || !reader.ReadBool(removed)) {
+			return false;
+		}
+		networkID += UnZigZag(idStep);
+
+		auto e = std::lower_bound(entries.begin(), entries.end(), networkID, EntryBeforeID);
+		bool found = e != entries.end() && e->networkID == networkID;
+		if (removed) {
+			if (found) {
+				entries.erase(e);
+			}
+			continue;
+		}
+
+		bool whole;
+		uint32_t fields = SnapshotState::AllFields;
+		if (!reader.ReadBool(whole) || (!whole && !reader.ReadBits(fields, 4))) {
+			return false;
+		}
+		if (!found) {
+			if (!whole) {
+				return false;
+			}
+			e = entries.insert(e, { networkID, SnapshotState() });
+		}
+		if (!e->state.ReadFields(reader, (uint8_t)fields, !whole)) {
+			return false;
+		}
+	}
+	return true;
+}
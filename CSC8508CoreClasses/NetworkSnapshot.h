@@ -0,0 +1,174 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "NetworkBase.h"
+#include "NetworkState.h"
+#include "BitStream.h"
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		An object's transform as it goes over the network. Positions are kept in
+		fixed point, within a set distance of the origin, and orientations in
+		smallest three form, so both ends agree exactly on what a state was, and
+		deltas between two states are whole numbers that come out small when
+		little has moved.
+		*/
+		struct SnapshotState {
+			static constexpr float		PositionScale	= 64.0f;		//Steps per world unit
+			static constexpr int32_t	PositionLimit	= 4096 * 64;	//Steps either way from the origin
+			static constexpr int		SmallDeltaBits	= 8;			//Enough for 2 units a tick
+			static constexpr int		OrientationBits = 10;
+
+			enum Fields : uint8_t {
+				PositionX	= 1 << 0,
+				PositionY	= 1 << 1,
+				PositionZ	= 1 << 2,
+				Orientation = 1 << 3,
+				AllFields	= PositionX | PositionY | PositionZ | Orientation
+			};
+
+			int32_t			position[3] = { 0, 0, 0 };
+			SmallestThree	orientation = SmallestThree::Compress(Quaternion(), OrientationBits);
+
+			static SnapshotState Quantise(const Vector3& position, const Quaternion& orientation);
+
+			Vector3		GetPosition() const;
+			Quaternion	GetOrientation() const;
+
+			uint8_t ChangedFields(const SnapshotState& from) const;
+
+			/*
+			Writes the given fields, as changes from another state if there is
+			one. A moving object's position and orientation come to 7 or 8 bytes.
+			*/
+			void WriteFields(BitWriter& writer, uint8_t fields, const SnapshotState* from) const;
+
+			//When reading changes, this should already hold the state they were taken from
+			bool ReadFields(BitReader& reader, uint8_t fields, bool changes);
+
+			bool operator==(const SnapshotState& other) const {
+				return ChangedFields(other) == 0;
+			}
+			bool operator!=(const SnapshotState& other) const {
+				return !(*this == other);
+			}
+		};
+
+		struct SnapshotEntry {
+			int				networkID;
+			SnapshotState	state;
+		};
+
+		struct SnapshotPacket;
+
+		/*
+		The state of every networked object at one server tick. Entries are kept
+		sorted by network ID, so a snapshot and its baseline can be walked side
+		by side when working out what changed between them.
+		*/
+		struct Snapshot {
+			int		id		= -1;
+			float	time	= 0.0f; //On the server's clock
+			std::vector<SnapshotEntry> entries;
+
+			void Clear() {
+				id		= -1;
+				time	= 0.0f;
+				entries.clear();
+			}
+
+			void Add(int networkID, const SnapshotState& state);
+			void Sort();
+
+			const SnapshotState* Find(int networkID) const;
+
+			/*
+			Writes only what differs from the baseline - objects that haven't
+			changed are left out altogether, and those that have only send the
+			fields that moved. With no baseline, every object is sent in full.
+			Objects are packed into as few packets as they fit in, and the
+			vector is kept between calls so its packets get reused. Returns the
+			number of packets used, or 0 if the snapshot needs more than
+			SnapshotPacket::MaxParts.
+			*/
+			int WriteDelta(const Snapshot* baseline, std::vector<SnapshotPacket>& packets) const;
+
+			/*
+			Starts rebuilding the snapshot the packet belongs to from the baseline
+			it was written against, then each of its parts is read in, in any
+			order, as no object is split across two parts.
+			*/
+			bool BeginDelta(const Snapshot* baseline, const SnapshotPacket& packet);
+			bool ReadDeltaPart(const SnapshotPacket& packet);
+		};
+
+		/*
+		The last few snapshots, for the server to delta against whichever one
+		each client last acknowledged, and for the client to rebuild states
+		from whichever one the server picked.
+		*/
+		class SnapshotBuffer {
+		public:
+			static constexpr int Size = 32; //A little over 1.5 seconds at 20hz
+
+			//Hands back a cleared snapshot, reusing the slot of the oldest one
+			Snapshot& Add(int id) {
+				Snapshot& s = snapshots[Slot(id)];
+				s.Clear();
+				s.id = id;
+				return s;
+			}
+
+			const Snapshot* Find(int id) const {
+				if (id < 0) {
+					return nullptr;
+				}
+				const Snapshot& s = snapshots[Slot(id)];
+				return s.id == id ? &s : nullptr;
+			}
+
+			void Clear() {
+				for (Snapshot& s : snapshots) {
+					s.Clear();
+				}
+			}
+
+		protected:
+			static int Slot(int id) {
+				return (int)((unsigned int)id % Size);
+			}
+
+			Snapshot snapshots[Size];
+		};
+
+		/*
+		One part of a snapshot. Each is kept under the usual network MTU, so
+		ENet never has to fragment them, and can send them unreliably.
+		*/
+		struct SnapshotPacket : public GamePacket {
+			static constexpr int MaxData	= 1176;
+			static constexpr int MaxParts	= 32;
+
+			int		snapshotID	= -1;
+			int		baselineID	= -1; //-1 if every object was sent in full
+			float	serverTime	= 0.0f;
+			short	objectCount = 0;
+			short	dataSize	= 0;
+			unsigned char partIndex = 0;
+			unsigned char partCount = 1;
+			char	data[MaxData];
+
+			SnapshotPacket() {
+				type = Snapshot_State;
+				SetDataSize(0);
+			}
+
+			//Only the used part of the data gets sent
+			void SetDataSize(int bytes) {
+				dataSize	= (short)bytes;
+				size		= (short)(sizeof(SnapshotPacket) - sizeof(GamePacket) - MaxData + bytes);
+			}
+		};
+	}
+}
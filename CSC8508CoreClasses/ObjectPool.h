@@ -0,0 +1,116 @@
+#pragma once
+#include <new>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include "MemoryArena.h"
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Fixed size blocks for every object deriving from Base. Derived classes
+		differ in size, so blocks are kept in size classes, each with its own
+		free list, and new blocks are cut from an arena, so objects of one kind
+		end up next to each other rather than scattered across the heap. Objects
+		too big for any size class go to the heap as usual.
+
+		Once a level is over and every object has been deleted, Reset drops the
+		arena in one go, rather than each block going back one at a time.
+
+		Objects should only be made and deleted from the main thread.
+		*/
+		template <typename Base>
+		class ObjectPool {
+		public:
+			static ObjectPool& Instance() {
+				static ObjectPool instance;
+				return instance;
+			}
+
+			ObjectPool(const ObjectPool&) = delete;
+			ObjectPool& operator=(const ObjectPool&) = delete;
+
+			void* Allocate(size_t size) {
+				if (size > MaxBlockSize) {
+					return ::operator new(size);
+				}
+				liveCount++;
+				size_t sizeClass = SizeClass(size);
+				FreeBlock* block = freeLists[sizeClass];
+				if (block) {
+					freeLists[sizeClass] = block->next;
+					return block;
+				}
+				return arena.Allocate((sizeClass + 1) * Granularity, Granularity);
+			}
+
+			void Free(void* p, size_t size) {
+				if (!p) {
+					return;
+				}
+				if (size > MaxBlockSize) {
+					::operator delete(p);
+					return;
+				}
+				liveCount--;
+				size_t sizeClass	= SizeClass(size);
+				FreeBlock* block	= (FreeBlock*)p;
+				block->next			= freeLists[sizeClass];
+				freeLists[sizeClass] = block;
+			}
+
+			//Returns false, and keeps everything, if any object is still alive
+			bool Reset() {
+				if (liveCount > 0) {
+					return false;
+				}
+				std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
+				arena.Reset();
+				return true;
+			}
+
+			int GetLiveCount() const {
+				return liveCount;
+			}
+
+		protected:
+			ObjectPool() : arena(16 * 1024) {
+				std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
+				liveCount = 0;
+			}
+
+			static constexpr size_t Granularity	= alignof(std::max_align_t);
+			static constexpr size_t MaxBlockSize = 1024;
+
+			static size_t SizeClass(size_t size) {
+				return (std::max<size_t>(size, 1) + Granularity - 1) / Granularity - 1;
+			}
+
+			struct FreeBlock {
+				FreeBlock* next;
+			};
+
+			FreeBlock*	freeLists[MaxBlockSize / Granularity];
+			MemoryArena	arena;
+			int			liveCount;
+		};
+
+		/*
+		Deriving from this sends new and delete for the class, and everything
+		derived from it, through ObjectPool<Base>. Deletes are given the size of
+		the object, so Base needs a virtual destructor if it's ever deleted
+		through a base pointer.
+		*/
+		template <typename Base>
+		class PoolAllocated {
+		public:
+			static void* operator new(size_t size) {
+				return ObjectPool<Base>::Instance().Allocate(size);
+			}
+
+			static void operator delete(void* p, size_t size) {
+				ObjectPool<Base>::Instance().Free(p, size);
+			}
+		};
+	}
+}
@@ -1,6 +1,7 @@
 #include "OrientationConstraint.h"
 #include "GameObject.h"
 #include "PhysicsObject.h"
+#include "PhysicsComponent.h"
 using namespace NCL;
 using namespace Maths;
 using namespace CSC8508;
@@ -18,4 +19,17 @@ OrientationConstraint::~OrientationConstraint()
 
 void OrientationConstraint::UpdateConstraint(float dt) {
 
-}
\ No newline at end of file
+}
+
+static PhysicsObject* GetPhysicsObject(GameObject* o) {
+	PhysicsComponent* phys = o->TryGetComponent<PhysicsComponent>();
+	return phys ? phys->GetPhysicsObject() : nullptr;
+}
+
+PhysicsObject* OrientationConstraint::GetPhysicsObjectA() const {
+	return GetPhysicsObject(objectA);
+}
+
+PhysicsObject* OrientationConstraint::GetPhysicsObjectB() const {
+	return GetPhysicsObject(objectB);
+}
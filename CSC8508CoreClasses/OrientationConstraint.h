@@ -13,6 +13,9 @@ namespace NCL {
 
 			void UpdateConstraint(float dt) override;
 
+			PhysicsObject* GetPhysicsObjectA() const override;
+			PhysicsObject* GetPhysicsObjectB() const override;
+
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Open addressing hash table of values keyed by an unordered pair of IDs.
+		The values are kept packed together in one array, so sweeping over every
+		pair is a straight walk through memory, while the slot array only holds
+		indices into it. Collisions are resolved by linear probing, and removals
+		shift later entries back rather than leaving tombstones, so lookups never
+		slow down as pairs come and go.
+		*/
+		template<class T>
+		class PairCache {
+		public:
+			struct Entry {
+				uint64_t	key;
+				T			value;
+			};
+
+			PairCache(int initialSlots = 64) {
+				int slotCount = 16;
+				while (slotCount < initialSlots) {
+					slotCount *= 2;
+				}
+				slots.assign(slotCount, EmptySlot);
+				slotMask = slotCount - 1;
+			}
+			~PairCache() {
+			}
+
+			//The same key is made whichever way round the IDs are given
+			static uint64_t MakeKey(int a, int b) {
+				uint32_t lo = (uint32_t)std::min(a, b);
+				uint32_t hi = (uint32_t)std::max(a, b);
+				return ((uint64_t)lo << 32) | hi;
+			}
+
+			void Clear() {
+				if (entries.empty()) {
+					return;
+				}
+				std::fill(slots.begin(), slots.end(), EmptySlot);
+				entries.clear();
+			}
+
+			int Size() const {
+				return (int)entries.size();
+			}
+
+			Entry& GetEntry(int i) {
+				return entries[i];
+			}
+
+			const Entry& GetEntry(int i) const {
+				return entries[i];
+			}
+
+			T* Find(uint64_t key) {
+				int slot = FindSlot(key);
+				return slot == EmptySlot ? nullptr : &entries[slots[slot]].value;
+			}
+
+			/*
+			Returns the value for the key, adding a default constructed one if it
+			wasn't already there - 'added' says which happened.
+			*/
+			T& Insert(uint64_t key, bool& added) {
+				if ((int)(entries.size() + 1) * 2 > (int)slots.size()) {
+					Grow();
+				}
+				int slot = HomeSlot(key);
+				while (slots[slot] != EmptySlot) {
+					Entry& e = entries[slots[slot]];
+					if (e.key == key) {
+						added = false;
+						return e.value;
+					}
+					slot = (slot + 1) & slotMask;
+				}
+				slots[slot] = (int)entries.size();
+				entries.push_back({ key, T() });
+				added = true;
+				return entries.back().value;
+			}
+
+			void Remove(uint64_t key) {
+				int slot = FindSlot(key);
+				if (slot != EmptySlot) {
+					RemoveAt(slots[slot]);
+				}
+			}
+
+			/*
+			The last entry is moved into the gap, so when removing while sweeping,
+			sweep from the back and every entry is still visited exactly once.
+			*/
+			void RemoveAt(int index) {
+				EraseSlot(FindSlot(entries[index].key));
+
+				int last = (int)entries.size() - 1;
+				if (index != last) {
+					slots[FindSlot(entries[last].key)] = index;
+					entries[index] = entries[last];
+				}
+				entries.pop_back();
+			}
+
+		protected:
+			static constexpr int EmptySlot = -1;
+
+			int HomeSlot(uint64_t key) const {
+				//Fibonacci hashing, so keys that only differ in their low IDs still spread out
+				return (int)((key * 0x9E3779B97F4A7C15ull) >> 32) & slotMask;
+			}
+
+			int FindSlot(uint64_t key) const {
+				int slot = HomeSlot(key);
+				while (slots[slot] != EmptySlot) {
+					if (entries[slots[slot]].key == key) {
+						return slot;
+					}
+					slot = (slot + 1) & slotMask;
+				}
+				return EmptySlot;
+			}
+
+			/*
+			Any entry further along the probe run that could live in the gap is
+			moved back into it, until the run ends, so no lookup ever stops short.
+			*/
+			void EraseSlot(int hole) {
+				int slot = (hole + 1) & slotMask;
+				while (slots[slot] != EmptySlot) {
+					int home = HomeSlot(entries[slots[slot]].key);
+					if (((slot - home) & slotMask) >= ((slot - hole) & slotMask)) {
+						slots[hole] = slots[slot];
+						hole = slot;
+					}
+					slot = (slot + 1) & slotMask;
+				}
+				slots[hole] = EmptySlot;
+			}
+
+			void Grow() {
+				slots.assign(slots.size() * 2, EmptySlot);
+				slotMask = (int)slots.size() - 1;
+				for (int i = 0; i < (int)entries.size(); ++i) {
+					int slot = HomeSlot(entries[i].key);
+					while (slots[slot] != EmptySlot) {
+						slot = (slot + 1) & slotMask;
+					}
+					slots[slot] = i;
+				}
+			}
+
+			std::vector<int>	slots;
+			std::vector<Entry>	entries;
+			int					slotMask;
+		};
+	}
+}
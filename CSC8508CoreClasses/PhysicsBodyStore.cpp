@@ -0,0 +1,358 @@
+#include "PhysicsBodyStore.h"
+#include "PhysicsObject.h"
+#include "Transform.h"
+
+using namespace NCL;
+using namespace CSC8508;
+
+/*
+A thin layer over whichever SIMD instruction set the build targets. Masks are
+all bits set in lanes where a comparison was true.
+*/
+#if defined(__AVX__)
+#include <immintrin.h>
+namespace {
+	typedef __m256 Lane;
+	const int LaneWidth = 8;
+
+	inline Lane Load(const float* p)		{ return _mm256_load_ps(p); }
+	inline void Store(float* p, Lane v)		{ _mm256_store_ps(p, v); }
+	inline Lane Splat(float f)				{ return _mm256_set1_ps(f); }
+	inline Lane Add(Lane a, Lane b)			{ return _mm256_add_ps(a, b); }
+	inline Lane Sub(Lane a, Lane b)			{ return _mm256_sub_ps(a, b); }
+	inline Lane Mul(Lane a, Lane b)			{ return _mm256_mul_ps(a, b); }
+	inline Lane Div(Lane a, Lane b)			{ return _mm256_div_ps(a, b); }
+	inline Lane Sqrt(Lane a)				{ return _mm256_sqrt_ps(a); }
+	inline Lane Greater(Lane a, Lane b)		{ return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	inline Lane Mask(Lane mask, Lane a)		{ return _mm256_and_ps(mask, a); }
+	inline Lane Select(Lane mask, Lane a, Lane b) { return _mm256_blendv_ps(b, a, mask); }
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+namespace {
+	typedef __m128 Lane;
+	const int LaneWidth = 4;
+
+	inline Lane Load(const float* p)		{ return _mm_load_ps(p); }
+	inline void Store(float* p, Lane v)		{ _mm_store_ps(p, v); }
+	inline Lane Splat(float f)				{ return _mm_set1_ps(f); }
+	inline Lane Add(Lane a, Lane b)			{ return _mm_add_ps(a, b); }
+	inline Lane Sub(Lane a, Lane b)			{ return _mm_sub_ps(a, b); }
+	inline Lane Mul(Lane a, Lane b)			{ return _mm_mul_ps(a, b); }
+	inline Lane Div(Lane a, Lane b)			{ return _mm_div_ps(a, b); }
+	inline Lane Sqrt(Lane a)				{ return _mm_sqrt_ps(a); }
+	inline Lane Greater(Lane a, Lane b)		{ return _mm_cmpgt_ps(a, b); }
+	inline Lane Mask(Lane mask, Lane a)		{ return _mm_and_ps(mask, a); }
+	inline Lane Select(Lane mask, Lane a, Lane b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+}
+#else
+namespace {
+	typedef float Lane;
+	const int LaneWidth = 1;
+
+	inline Lane Load(const float* p)		{ return *p; }
+	inline void Store(float* p, Lane v)		{ *p = v; }
+	inline Lane Splat(float f)				{ return f; }
+	inline Lane Add(Lane a, Lane b)			{ return a + b; }
+	inline Lane Sub(Lane a, Lane b)			{ return a - b; }
+	inline Lane Mul(Lane a, Lane b)			{ return a * b; }
+	inline Lane Div(Lane a, Lane b)			{ return a / b; }
+	inline Lane Sqrt(Lane a)				{ return std::sqrt(a); }
+	inline Lane Greater(Lane a, Lane b)		{ return a > b ? 1.0f : 0.0f; }
+	inline Lane Mask(Lane mask, Lane a)		{ return mask != 0.0f ? a : 0.0f; }
+	inline Lane Select(Lane mask, Lane a, Lane b) { return mask != 0.0f ? a : b; }
+}
+#endif
+
+//Room for 8 lanes, whichever instruction set is in use
+const int paddingWidth = 8;
+
+PhysicsBodyStore::PhysicsBodyStore() {
+	bodyCount	= 0;
+	capacity	= 0;
+
+	channels = {
+		{ &posX, 0.0f }, { &posY, 0.0f }, { &posZ, 0.0f },
+		{ &rotX, 0.0f }, { &rotY, 0.0f }, { &rotZ, 0.0f }, { &rotW, 1.0f },
+		{ &linX, 0.0f }, { &linY, 0.0f }, { &linZ, 0.0f },
+		{ &angX, 0.0f }, { &angY, 0.0f }, { &angZ, 0.0f },
+		{ &forceX, 0.0f }, { &forceY, 0.0f }, { &forceZ, 0.0f },
+		{ &torqueX, 0.0f }, { &torqueY, 0.0f }, { &torqueZ, 0.0f },
+		{ &inverseMass, 0.0f },
+		{ &invInertiaX, 0.0f }, { &invInertiaY, 0.0f }, { &invInertiaZ, 0.0f },
+		{ &tensorXX, 0.0f }, { &tensorXY, 0.0f }, { &tensorXZ, 0.0f },
+		{ &tensorYY, 0.0f }, { &tensorYZ, 0.0f }, { &tensorZZ, 0.0f },
+		{ &awake, 0.0f },
+		{ &inWorld, 0.0f },
+		{ &simulate, 0.0f }
+	};
+}
+
+int PhysicsBodyStore::AddBody(PhysicsObject* owner, Transform* transform) {
+	if (bodyCount == capacity) {
+		Grow();
+	}
+	int body = bodyCount++;
+	ResetBody(body);
+	transforms[body]	= transform;
+	owners[body]		= owner;
+
+	Vector3 position		= transform->GetPosition();
+	Quaternion orientation	= transform->GetOrientation();
+	posX[body] = position.x;	posY[body] = position.y;	posZ[body] = position.z;
+	rotX[body] = orientation.x; rotY[body] = orientation.y; rotZ[body] = orientation.z; rotW[body] = orientation.w;
+	awake[body] = 1.0f;
+	return body;
+}
+
+void PhysicsBodyStore::RemoveBody(int body) {
+	int last = bodyCount - 1;
+	if (body != last) {
+		for (auto& c : channels) {
+			(*c.first)[body] = (*c.first)[last];
+		}
+		transforms[body]	= transforms[last];
+		owners[body]		= owners[last];
+		owners[body]->bodyIndex = body;
+	}
+	ResetBody(last);
+	bodyCount--;
+}
+
+void PhysicsBodyStore::Grow() {
+	capacity = std::max(capacity * 2, 64);
+	capacity = ((capacity + paddingWidth - 1) / paddingWidth) * paddingWidth;
+	for (auto& c : channels) {
+		c.first->resize(capacity, c.second);
+	}
+	transforms.resize(capacity, nullptr);
+	owners.resize(capacity, nullptr);
+}
+
+void PhysicsBodyStore::ResetBody(int body) {
+	for (auto& c : channels) {
+		(*c.first)[body] = c.second;
+	}
+	transforms[body]	= nullptr;
+	owners[body]		= nullptr;
+}
+
+/*
+Called at the start of each physics update. Only the bodies gathered in will
+be simulated, and their transforms are read in fresh, in case they were moved
+by anything since the last update.
+*/
+void PhysicsBodyStore::BeginGather() {
+	std::fill(inWorld.begin(), inWorld.end(), 0.0f);
+	std::fill(simulate.begin(), simulate.end(), 0.0f);
+}
+
+void PhysicsBodyStore::GatherBody(int body) {
+	const Transform* t		= transforms[body];
+	Vector3 position		= t->GetPosition();
+	Quaternion orientation	= t->GetOrientation();
+	posX[body] = position.x;	posY[body] = position.y;	posZ[body] = position.z;
+	rotX[body] = orientation.x; rotY[body] = orientation.y; rotZ[body] = orientation.z; rotW[body] = orientation.w;
+
+	inWorld[body]	= 1.0f;
+	simulate[body]	= awake[body];
+}
+
+void PhysicsBodyStore::IntegrateAccel(float dt, const Vector3& gravity) {
+	Lane zero	= Splat(0.0f);
+	Lane dtL	= Splat(dt);
+	Lane gx		= Splat(gravity.x);
+	Lane gy		= Splat(gravity.y);
+	Lane gz		= Splat(gravity.z);
+
+	for (int i = 0; i < bodyCount; i += LaneWidth) {
+		Lane step		= Mul(Load(&simulate[i]), dtL);
+		Lane invMass	= Load(&inverseMass[i]);
+		Lane hasMass	= Greater(invMass, zero);
+
+		Lane ax = Add(Mul(Load(&forceX[i]), invMass), Mask(hasMass, gx));
+		Lane ay = Add(Mul(Load(&forceY[i]), invMass), Mask(hasMass, gy));
+		Lane az = Add(Mul(Load(&forceZ[i]), invMass), Mask(hasMass, gz));
+
+		Store(&linX[i], Add(Load(&linX[i]), Mul(ax, step)));
+		Store(&linY[i], Add(Load(&linY[i]), Mul(ay, step)));
+		Store(&linZ[i], Add(Load(&linZ[i]), Mul(az, step)));
+
+		Lane tx = Load(&torqueX[i]);
+		Lane ty = Load(&torqueY[i]);
+		Lane tz = Load(&torqueZ[i]);
+
+		Lane ixx = Load(&tensorXX[i]), ixy = Load(&tensorXY[i]), ixz = Load(&tensorXZ[i]);
+		Lane iyy = Load(&tensorYY[i]), iyz = Load(&tensorYZ[i]), izz = Load(&tensorZZ[i]);
+
+		Lane alx = Add(Add(Mul(ixx, tx), Mul(ixy, ty)), Mul(ixz, tz));
+		Lane aly = Add(Add(Mul(ixy, tx), Mul(iyy, ty)), Mul(iyz, tz));
+		Lane alz = Add(Add(Mul(ixz, tx), Mul(iyz, ty)), Mul(izz, tz));
+
+		Store(&angX[i], Add(Load(&angX[i]), Mul(alx, step)));
+		Store(&angY[i], Add(Load(&angY[i]), Mul(aly, step)));
+		Store(&angZ[i], Add(Load(&angZ[i]), Mul(alz, step)));
+	}
+}
+
+void PhysicsBodyStore::IntegrateVelocity(float dt, float linearDamping, float angularDamping) {
+	Lane zero		= Splat(0.0f);
+	Lane dtL		= Splat(dt);
+	Lane halfDt		= Splat(dt * 0.5f);
+	Lane linDamp	= Splat(linearDamping);
+	Lane angDamp	= Splat(angularDamping);
+
+	for (int i = 0; i < bodyCount; i += LaneWidth) {
+		Lane active = Greater(Load(&simulate[i]), zero);
+		Lane step	= Mask(active, dtL);
+
+		Lane vx = Load(&linX[i]);
+		Lane vy = Load(&linY[i]);
+		Lane vz = Load(&linZ[i]);
+
+		Store(&posX[i], Add(Load(&posX[i]), Mul(vx, step)));
+		Store(&posY[i], Add(Load(&posY[i]), Mul(vy, step)));
+		Store(&posZ[i], Add(Load(&posZ[i]), Mul(vz, step)));
+
+		Store(&linX[i], Select(active, Mul(vx, linDamp), vx));
+		Store(&linY[i], Select(active, Mul(vy, linDamp), vy));
+		Store(&linZ[i], Select(active, Mul(vz, linDamp), vz));
+
+		//q += (w * dt/2, 0) * q, then renormalised
+		Lane wx = Load(&angX[i]);
+		Lane wy = Load(&angY[i]);
+		Lane wz = Load(&angZ[i]);
+
+		Lane hx = Mul(wx, halfDt);
+		Lane hy = Mul(wy, halfDt);
+		Lane hz = Mul(wz, halfDt);
+
+		Lane qx = Load(&rotX[i]);
+		Lane qy = Load(&rotY[i]);
+		Lane qz = Load(&rotZ[i]);
+		Lane qw = Load(&rotW[i]);
+
+		Lane nx = Add(qx, Sub(Add(Mul(hx, qw), Mul(hy, qz)), Mul(hz, qy)));
+		Lane ny = Add(qy, Sub(Add(Mul(hy, qw), Mul(hz, qx)), Mul(hx, qz)));
+		Lane nz = Add(qz, Sub(Add(Mul(hz, qw), Mul(hx, qy)), Mul(hy, qx)));
+		Lane nw = Sub(qw, Add(Add(Mul(hx, qx), Mul(hy, qy)), Mul(hz, qz)));
+
+		Lane length		= Sqrt(Add(Add(Mul(nx, nx), Mul(ny, ny)), Add(Mul(nz, nz), Mul(nw, nw))));
+		Lane normalise	= Select(active, Greater(length, zero), zero);
+		Lane invLength	= Div(Splat(1.0f), Select(normalise, length, Splat(1.0f)));
+
+		Store(&rotX[i], Select(normalise, Mul(nx, invLength), qx));
+		Store(&rotY[i], Select(normalise, Mul(ny, invLength), qy));
+		Store(&rotZ[i], Select(normalise, Mul(nz, invLength), qz));
+		Store(&rotW[i], Select(normalise, Mul(nw, invLength), qw));
+
+		Store(&angX[i], Select(active, Mul(wx, angDamp), wx));
+		Store(&angY[i], Select(active, Mul(wy, angDamp), wy));
+		Store(&angZ[i], Select(active, Mul(wz, angDamp), wz));
+	}
+}
+
+/*
+Builds R * inverse(I) * transpose(R) for each body. Only bodies that have just
+been integrated can have rotated, so after the first pass of an update only
+those need doing.
+*/
+void PhysicsBodyStore::UpdateInertiaTensors(bool onlySimulated) {
+	Lane zero	= Splat(0.0f);
+	Lane one	= Splat(1.0f);
+	Lane two	= Splat(2.0f);
+
+	for (int i = 0; i < bodyCount; i += LaneWidth) {
+		Lane update = onlySimulated ? Greater(Load(&simulate[i]), zero) : Greater(one, zero);
+
+		Lane x = Load(&rotX[i]);
+		Lane y = Load(&rotY[i]);
+		Lane z = Load(&rotZ[i]);
+		Lane w = Load(&rotW[i]);
+
+		Lane xx = Mul(x, x), yy = Mul(y, y), zz = Mul(z, z);
+		Lane xy = Mul(x, y), xz = Mul(x, z), yz = Mul(y, z);
+		Lane xw = Mul(x, w), yw = Mul(y, w), zw = Mul(z, w);
+
+		Lane r00 = Sub(one, Mul(two, Add(yy, zz)));
+		Lane r01 = Mul(two, Sub(xy, zw));
+		Lane r02 = Mul(two, Add(xz, yw));
+		Lane r10 = Mul(two, Add(xy, zw));
+		Lane r11 = Sub(one, Mul(two, Add(xx, zz)));
+		Lane r12 = Mul(two, Sub(yz, xw));
+		Lane r20 = Mul(two, Sub(xz, yw));
+		Lane r21 = Mul(two, Add(yz, xw));
+		Lane r22 = Sub(one, Mul(two, Add(xx, yy)));
+
+		Lane dx = Load(&invInertiaX[i]);
+		Lane dy = Load(&invInertiaY[i]);
+		Lane dz = Load(&invInertiaZ[i]);
+
+		auto entry = [&](Lane a0, Lane a1, Lane a2, Lane b0, Lane b1, Lane b2) {
+			return Add(Add(Mul(Mul(a0, b0), dx), Mul(Mul(a1, b1), dy)), Mul(Mul(a2, b2), dz));
+		};
+		Store(&tensorXX[i], Select(update, entry(r00, r01, r02, r00, r01, r02), Load(&tensorXX[i])));
+		Store(&tensorXY[i], Select(update, entry(r00, r01, r02, r10, r11, r12), Load(&tensorXY[i])));
+		Store(&tensorXZ[i], Select(update, entry(r00, r01, r02, r20, r21, r22), Load(&tensorXZ[i])));
+		Store(&tensorYY[i], Select(update, entry(r10, r11, r12, r10, r11, r12), Load(&tensorYY[i])));
+		Store(&tensorYZ[i], Select(update, entry(r10, r11, r12, r20, r21, r22), Load(&tensorYZ[i])));
+		Store(&tensorZZ[i], Select(update, entry(r20, r21, r22, r20, r21, r22), Load(&tensorZZ[i])));
+	}
+}
+
+void PhysicsBodyStore::UpdateInertiaTensor(int body) {
+	Quaternion q(rotX[body], rotY[body], rotZ[body], rotW[body]);
+	Matrix3 tensor = Quaternion::RotationMatrix<Matrix3>(q) * Matrix::Scale3x3(GetInverseInertia(body)) * Quaternion::RotationMatrix<Matrix3>(q.Conjugate());
+
+	tensorXX[body] = tensor.array[0][0];
+	tensorXY[body] = tensor.array[1][0];
+	tensorXZ[body] = tensor.array[2][0];
+	tensorYY[body] = tensor.array[1][1];
+	tensorYZ[body] = tensor.array[2][1];
+	tensorZZ[body] = tensor.array[2][2];
+}
+
+Matrix3 PhysicsBodyStore::GetInertiaTensor(int body) const {
+	Matrix3 m;
+	m.array[0][0] = tensorXX[body];
+	m.array[0][1] = tensorXY[body];
+	m.array[0][2] = tensorXZ[body];
+	m.array[1][0] = tensorXY[body];
+	m.array[1][1] = tensorYY[body];
+	m.array[1][2] = tensorYZ[body];
+	m.array[2][0] = tensorXZ[body];
+	m.array[2][1] = tensorYZ[body];
+	m.array[2][2] = tensorZZ[body];
+	return m;
+}
+
+/*
+One pass over the bodies that moved this step, so each transform's matrix is
+only rebuilt once. Bodies that didn't move stop being blended between steps.
+*/
+void PhysicsBodyStore::WriteTransforms() {
+	for (int i = 0; i < bodyCount; ++i) {
+		if (simulate[i] == 0.0f) {
+			if (inWorld[i] != 0.0f) {
+				transforms[i]->StopInterpolating();
+			}
+			continue;
+		}
+		transforms[i]->StepTo(
+			Vector3(posX[i], posY[i], posZ[i]),
+			Quaternion(rotX[i], rotY[i], rotZ[i], rotW[i]));
+	}
+}
+
+void PhysicsBodyStore::ClearForces() {
+	Lane zero = Splat(0.0f);
+	for (int i = 0; i < bodyCount; i += LaneWidth) {
+		Lane clear = Greater(Load(&inWorld[i]), zero);
+		Store(&forceX[i],	Select(clear, zero, Load(&forceX[i])));
+		Store(&forceY[i],	Select(clear, zero, Load(&forceY[i])));
+		Store(&forceZ[i],	Select(clear, zero, Load(&forceZ[i])));
+		Store(&torqueX[i],	Select(clear, zero, Load(&torqueX[i])));
+		Store(&torqueY[i],	Select(clear, zero, Load(&torqueY[i])));
+		Store(&torqueZ[i],	Select(clear, zero, Load(&torqueZ[i])));
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <new>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8508 {
+		class Transform;
+		class PhysicsObject;
+
+		/*
+		Keeps each array on a 32 byte boundary, so the integration kernels can
+		use aligned SSE and AVX loads.
+		*/
+		template <typename T>
+		struct AlignedAllocator {
+			typedef T value_type;
+			static const size_t Alignment = 32;
+
+			AlignedAllocator() {}
+			template <typename U>
+			AlignedAllocator(const AlignedAllocator<U>&) {}
+
+			T* allocate(size_t n) {
+				return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+			}
+			void deallocate(T* p, size_t) {
+				::operator delete(p, std::align_val_t(Alignment));
+			}
+			template <typename U>
+			bool operator==(const AlignedAllocator<U>&) const { return true; }
+			template <typename U>
+			bool operator!=(const AlignedAllocator<U>&) const { return false; }
+		};
+
+		typedef std::vector<float, AlignedAllocator<float>> FloatArray;
+
+		/*
+		Every rigid body's simulation state, stored as one array per component,
+		so the integration steps can run over several bodies at once with SIMD
+		instructions. PhysicsObjects are handles into this store: removing a body
+		moves the last body into its slot and updates that body's handle.
+
+		The arrays are always padded out to a whole number of SIMD lanes. Bodies
+		are only integrated when 'simulate' is set - they're in a world that's
+		being updated, and they're awake.
+		*/
+		class PhysicsBodyStore {
+		public:
+			static PhysicsBodyStore& Instance() {
+				static PhysicsBodyStore instance;
+				return instance;
+			}
+
+			PhysicsBodyStore(const PhysicsBodyStore&) = delete;
+			PhysicsBodyStore& operator=(const PhysicsBodyStore&) = delete;
+
+			int  AddBody(PhysicsObject* owner, Transform* transform);
+			void RemoveBody(int body);
+
+			int GetBodyCount() const {
+				return bodyCount;
+			}
+
+			//Batched passes, run by the PhysicsSystem
+			void BeginGather();
+			void GatherBody(int body);
+			void IntegrateAccel(float dt, const Vector3& gravity);
+			void IntegrateVelocity(float dt, float linearDamping, float angularDamping);
+			void UpdateInertiaTensors(bool onlySimulated);
+			void WriteTransforms();
+			void ClearForces();
+
+			void UpdateInertiaTensor(int body);
+
+			Vector3 GetPosition(int body) const {
+				return Vector3(posX[body], posY[body], posZ[body]);
+			}
+
+			void SetPosition(int body, const Vector3& p) {
+				posX[body] = p.x; posY[body] = p.y; posZ[body] = p.z;
+			}
+
+			Vector3 GetLinearVelocity(int body) const {
+				return Vector3(linX[body], linY[body], linZ[body]);
+			}
+
+			void SetLinearVelocity(int body, const Vector3& v) {
+				linX[body] = v.x; linY[body] = v.y; linZ[body] = v.z;
+			}
+
+			Vector3 GetAngularVelocity(int body) const {
+				return Vector3(angX[body], angY[body], angZ[body]);
+			}
+
+			void SetAngularVelocity(int body, const Vector3& v) {
+				angX[body] = v.x; angY[body] = v.y; angZ[body] = v.z;
+			}
+
+			Vector3 GetForce(int body) const {
+				return Vector3(forceX[body], forceY[body], forceZ[body]);
+			}
+
+			void SetForce(int body, const Vector3& f) {
+				forceX[body] = f.x; forceY[body] = f.y; forceZ[body] = f.z;
+			}
+
+			Vector3 GetTorque(int body) const {
+				return Vector3(torqueX[body], torqueY[body], torqueZ[body]);
+			}
+
+			void SetTorque(int body, const Vector3& t) {
+				torqueX[body] = t.x; torqueY[body] = t.y; torqueZ[body] = t.z;
+			}
+
+			float GetInverseMass(int body) const {
+				return inverseMass[body];
+			}
+
+			void SetInverseMass(int body, float invMass) {
+				inverseMass[body] = invMass;
+			}
+
+			Vector3 GetInverseInertia(int body) const {
+				return Vector3(invInertiaX[body], invInertiaY[body], invInertiaZ[body]);
+			}
+
+			void SetInverseInertia(int body, const Vector3& i) {
+				invInertiaX[body] = i.x; invInertiaY[body] = i.y; invInertiaZ[body] = i.z;
+			}
+
+			Matrix3 GetInertiaTensor(int body) const;
+
+			Vector3 MultiplyInertiaTensor(int body, const Vector3& v) const {
+				return Vector3(
+					tensorXX[body] * v.x + tensorXY[body] * v.y + tensorXZ[body] * v.z,
+					tensorXY[body] * v.x + tensorYY[body] * v.y + tensorYZ[body] * v.z,
+					tensorXZ[body] * v.x + tensorYZ[body] * v.y + tensorZZ[body] * v.z);
+			}
+
+			bool IsAwake(int body) const {
+				return awake[body] != 0.0f;
+			}
+
+			void SetAwake(int body, bool state) {
+				awake[body]		= state ? 1.0f : 0.0f;
+				simulate[body]	= awake[body] * inWorld[body];
+			}
+
+		protected:
+			PhysicsBodyStore();
+			~PhysicsBodyStore() {}
+
+			void Grow();
+			void ResetBody(int body);
+
+			int bodyCount;
+			int capacity;
+
+			FloatArray posX, posY, posZ;
+			FloatArray rotX, rotY, rotZ, rotW;
+			FloatArray linX, linY, linZ;
+			FloatArray angX, angY, angZ;
+			FloatArray forceX, forceY, forceZ;
+			FloatArray torqueX, torqueY, torqueZ;
+			FloatArray inverseMass;
+			FloatArray invInertiaX, invInertiaY, invInertiaZ;
+			FloatArray tensorXX, tensorXY, tensorXZ, tensorYY, tensorYZ, tensorZZ; //Symmetric, so only 6 are needed
+			FloatArray awake;
+			FloatArray inWorld;
+			FloatArray simulate;
+
+			//Every array above, with the value unused slots hold, so they can be grown and moved as one
+			std::vector<std::pair<FloatArray*, float>> channels;
+
+			std::vector<Transform*>		transforms;
+			std::vector<PhysicsObject*> owners;
+		};
+	}
+}
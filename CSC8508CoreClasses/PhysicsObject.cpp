@@ -7,44 +7,114 @@ using namespace CSC8508;
 PhysicsObject::PhysicsObject(Transform* parentTransform, const CollisionVolume* parentVolume)	{
 	transform	= parentTransform;
 	volume		= parentVolume;
+	bodyIndex	= PhysicsBodyStore::Instance().AddBody(this, parentTransform);
 
-	inverseMass = 1.0f;
+	SetInverseMass(1.0f);
 	elasticity	= 0.8f;
 	friction	= 0.8f;
+
+	continuousCollision = false;
+
+	sleepTimer		= 0.0f;
+	islandIndex		= -1;
+	nextInIsland	= nullptr;
 }
 
 PhysicsObject::~PhysicsObject()	{
-
+	//Anything left resting on this object needs to notice it's gone
+	WakeUp();
+	PhysicsBodyStore::Instance().RemoveBody(bodyIndex);
 }
 
 void PhysicsObject::ApplyAngularImpulse(const Vector3& force) {
-	angularVelocity += inverseInteriaTensor * force;
+	WakeFromImpulse();
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.SetAngularVelocity(bodyIndex, store.GetAngularVelocity(bodyIndex) + store.MultiplyInertiaTensor(bodyIndex, force));
 }
 
 void PhysicsObject::ApplyLinearImpulse(const Vector3& force) {
-	linearVelocity += force * inverseMass;
+	WakeFromImpulse();
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.SetLinearVelocity(bodyIndex, store.GetLinearVelocity(bodyIndex) + force * store.GetInverseMass(bodyIndex));
 }
 
 void PhysicsObject::AddForce(const Vector3& addedForce) {
-	force += addedForce;
+	WakeFromImpulse();
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.SetForce(bodyIndex, store.GetForce(bodyIndex) + addedForce);
 }
 
 void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3& position) {
+	WakeFromImpulse();
 	Vector3 localPos = position - transform->GetPosition();
 
-	force  += addedForce;
-	torque += Vector::Cross(localPos, addedForce);
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.SetForce(bodyIndex, store.GetForce(bodyIndex) + addedForce);
+	store.SetTorque(bodyIndex, store.GetTorque(bodyIndex) + Vector::Cross(localPos, addedForce));
 }
 
 void PhysicsObject::AddTorque(const Vector3& addedTorque) {
-	torque += addedTorque;
+	WakeFromImpulse();
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.SetTorque(bodyIndex, store.GetTorque(bodyIndex) + addedTorque);
+}
+
+//Nothing applied to an immovable object can change how it moves
+void PhysicsObject::WakeFromImpulse() {
+	if (!IsAwake() && GetInverseMass() > 0.0f) {
+		WakeUp();
+	}
+}
+
+/*
+The timer counts how long the object has been moving slowly enough to sleep,
+and starts again as soon as it speeds up.
+*/
+void PhysicsObject::UpdateSleepTimer(float dt, float linearThreshold, float angularThreshold) {
+	if (Vector::LengthSquared(GetLinearVelocity()) > linearThreshold * linearThreshold ||
+		Vector::LengthSquared(GetAngularVelocity()) > angularThreshold * angularThreshold) {
+		sleepTimer = 0.0f;
+	}
+	else {
+		sleepTimer += dt;
+	}
+}
+
+/*
+Waking any object wakes every other object that went to sleep in the same
+island, as they were only ever at rest because of each other.
+*/
+void PhysicsObject::WakeUp() {
+	if (IsAwake()) {
+		return;
+	}
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	PhysicsObject* o = this;
+	do {
+		PhysicsObject* next = o->nextInIsland;
+		store.SetAwake(o->bodyIndex, true);
+		o->sleepTimer	= 0.0f;
+		o->nextInIsland = nullptr;
+		o = next;
+	} while (o && o != this);
+}
+
+void PhysicsObject::Sleep(PhysicsObject* next) {
+	nextInIsland	= next;
+
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.SetAwake(bodyIndex, false);
+	store.SetLinearVelocity(bodyIndex, Vector3());
+	store.SetAngularVelocity(bodyIndex, Vector3());
+	store.SetForce(bodyIndex, Vector3());
+	store.SetTorque(bodyIndex, Vector3());
 }
 
 float PhysicsObject::GetFriction() { return friction; }
 
 void PhysicsObject::ClearForces() {
-	force				= Vector3();
-	torque				= Vector3();
+	PhysicsBodyStore::Instance().SetForce(bodyIndex, Vector3());
+	PhysicsBodyStore::Instance().SetTorque(bodyIndex, Vector3());
 }
 
 void  PhysicsObject::RotateTowardsVelocity(float offset) {
@@ -62,25 +132,24 @@ void PhysicsObject::InitCubeInertia() {
 
 	Vector3 dimsSqr		= fullWidth * fullWidth;
 
+	float inverseMass = GetInverseMass();
+
+	Vector3 inverseInertia;
 	inverseInertia.x = (12.0f * inverseMass) / (dimsSqr.y + dimsSqr.z);
 	inverseInertia.y = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.z);
 	inverseInertia.z = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.y);
+	PhysicsBodyStore::Instance().SetInverseInertia(bodyIndex, inverseInertia);
 }
 
 void PhysicsObject::InitSphereInertia() {
 
 	float radius	= Vector::GetMaxElement(transform->GetScale());
-	float i			= 2.5f * inverseMass / (radius*radius);
+	float i			= 2.5f * GetInverseMass() / (radius*radius);
 
-	inverseInertia	= Vector3(i, i, i);
+	PhysicsBodyStore::Instance().SetInverseInertia(bodyIndex, Vector3(i, i, i));
 }
 
 void PhysicsObject::UpdateInertiaTensor() {
-	Quaternion q = transform->GetOrientation();
-
-	Matrix3 invOrientation = Quaternion::RotationMatrix<Matrix3>(q.Conjugate());
-	Matrix3 orientation = Quaternion::RotationMatrix<Matrix3>(q);
-
-	inverseInteriaTensor = orientation * Matrix::Scale3x3(inverseInertia) *invOrientation;
+	PhysicsBodyStore::Instance().UpdateInertiaTensor(bodyIndex);
 }
 
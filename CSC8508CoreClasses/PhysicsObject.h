@@ -1,4 +1,7 @@
 #pragma once
+#include "PhysicsBodyStore.h"
+#include "ObjectPool.h"
+
 using namespace NCL::Maths;
 
 namespace NCL {
@@ -7,34 +10,42 @@ namespace NCL {
 	namespace CSC8508 {
 		class Transform;
 
-		class PhysicsObject	{
+		/*
+		A handle to a body in the PhysicsBodyStore, where the state the integrator
+		works on is kept. Material properties and sleep bookkeeping, which the
+		integrator never touches, stay in the object itself.
+		*/
+		class PhysicsObject : public PoolAllocated<PhysicsObject>	{
 		public:
 			PhysicsObject(Transform* parentTransform, const CollisionVolume* parentVolume);
 			~PhysicsObject();
 
+			PhysicsObject(const PhysicsObject&) = delete;
+			PhysicsObject& operator=(const PhysicsObject&) = delete;
+
 			Vector3 GetLinearVelocity() const {
-				return linearVelocity;
+				return PhysicsBodyStore::Instance().GetLinearVelocity(bodyIndex);
 			}
 
 			Vector3 GetAngularVelocity() const {
-				return angularVelocity;
+				return PhysicsBodyStore::Instance().GetAngularVelocity(bodyIndex);
 			}
 
 			Vector3 GetTorque() const {
-				return torque;
+				return PhysicsBodyStore::Instance().GetTorque(bodyIndex);
 			}
 
 
 			Vector3 GetForce() const {
-				return force;
+				return PhysicsBodyStore::Instance().GetForce(bodyIndex);
 			}
 
 			void SetInverseMass(float invMass) {
-				inverseMass = invMass;
+				PhysicsBodyStore::Instance().SetInverseMass(bodyIndex, invMass);
 			}
 
 			float GetInverseMass() const {
-				return inverseMass;
+				return PhysicsBodyStore::Instance().GetInverseMass(bodyIndex);
 			}
 
 
@@ -56,44 +67,81 @@ namespace NCL {
 			void ClearForces();
 
 			void SetLinearVelocity(const Vector3& v) {
-				linearVelocity = v;
+				PhysicsBodyStore::Instance().SetLinearVelocity(bodyIndex, v);
+				if (!IsAwake() && Vector::LengthSquared(v) > 0.0f) {
+					WakeUp();
+				}
 			}
 
 			void SetAngularVelocity(const Vector3& v) {
-				angularVelocity = v;
+				PhysicsBodyStore::Instance().SetAngularVelocity(bodyIndex, v);
+				if (!IsAwake() && Vector::LengthSquared(v) > 0.0f) {
+					WakeUp();
+				}
+			}
+
+			bool IsAwake() const {
+				return PhysicsBodyStore::Instance().IsAwake(bodyIndex);
+			}
+
+			float GetSleepTimer() const {
+				return sleepTimer;
+			}
+
+			void UpdateSleepTimer(float dt, float linearThreshold, float angularThreshold);
+
+			void WakeUp();
+			void Sleep(PhysicsObject* nextInIsland);
+
+			int GetIslandIndex() const {
+				return islandIndex;
+			}
+
+			void SetIslandIndex(int index) {
+				islandIndex = index;
+			}
+
+			int GetBodyIndex() const {
+				return bodyIndex;
+			}
+
+			//Fast moving objects can ask to be swept against static geometry, so they can't pass through it
+			void UseContinuousCollision(bool state) {
+				continuousCollision = state;
+			}
+
+			bool UsesContinuousCollision() const {
+				return continuousCollision;
 			}
 
 			void InitCubeInertia();
 			void InitSphereInertia();
-			void IntegrateVelocity(float dt);
-			void IntegrateAccel(float dt);
 
 			void UpdateInertiaTensor();
 
 
 			Matrix3 GetInertiaTensor() const {
-				return inverseInteriaTensor;
+				return PhysicsBodyStore::Instance().GetInertiaTensor(bodyIndex);
 			}
 
 		protected:
+			friend class PhysicsBodyStore;
+
 			const CollisionVolume* volume;
 			Transform*		transform;
+			int				bodyIndex;
 
-			float inverseMass;
 			float elasticity;
 			float friction;
 			float cRestitution; 
+			bool  continuousCollision;
 
-			//linear stuff
-			Vector3 linearVelocity;
-			Vector3 force;
-			
-			//angular stuff
-			Vector3 angularVelocity;
-			Vector3 torque;
-			Vector3 inverseInertia;
-			Matrix3 inverseInteriaTensor;
+			void WakeFromImpulse();
+
+			//sleeping
+			float	sleepTimer;
+			int		islandIndex;
+			PhysicsObject* nextInIsland; //Sleeping islands are kept as a ring, so they wake together
 		};
 	}
 }
-
@@ -17,37 +17,49 @@ using namespace CSC8508;
 
 PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)	{
 	applyGravity	= false;
-	useBroadPhase	= false;	
+	broadPhaseMode	= BroadPhaseMode::DynamicTree;
 	dTOffset		= 0.0f;
 	globalDamping	= 0.995f;
 	SetGravity(Vector3(0.0f, -9.8f, 0.0f));
+
+	for (int i = 0; i < Layers::MaxLayers; ++i) {
+		layerCollisions[i] = Layers::AllLayers;
+	}
+	gameWorld.AddRemovalListener([this]() { EndDepartedCollisions(); });
 }
 
 PhysicsSystem::~PhysicsSystem()	{
 }
 
+void PhysicsSystem::SetLayerCollision(Layers::LayerID a, Layers::LayerID b, bool state) {
+	if (state) {
+		layerCollisions[a] |= Layers::ToMask(b);
+		layerCollisions[b] |= Layers::ToMask(a);
+	}
+	else {
+		layerCollisions[a] &= ~Layers::ToMask(b);
+		layerCollisions[b] &= ~Layers::ToMask(a);
+	}
+}
+
 void PhysicsSystem::SetGravity(const Vector3& g) {
 	gravity = g;
 }
 
 void PhysicsSystem::Clear() {
-	allCollisions.clear();
+	allCollisions.Clear();
+	collisionEvents.clear();
+	contactManifolds.clear();
 }
 
 bool useSimpleContainer = false;
 
 int constraintIterationCount = 10;
 
-const int   idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
-
-int realHZ		= idealHZ;
-float realDT	= idealDT;
-
 void PhysicsSystem::DebugConstraints() {
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
+		broadPhaseMode = (BroadPhaseMode)(((int)broadPhaseMode + 1) % ((int)BroadPhaseMode::SweepAndPrune + 1));
+		std::cout << "Setting broadphase to " << (int)broadPhaseMode << std::endl;
 	}
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
 		useSimpleContainer = !useSimpleContainer;
@@ -63,189 +75,255 @@ void PhysicsSystem::DebugConstraints() {
 	}
 }
 
+/*
+The simulation always moves on in whole steps of the same length, whatever the
+frame rate, so it behaves the same everywhere. Time left over is carried on to
+the next frame, and tells rendering how far between the last two steps to draw
+things. If a frame would need more than the step budget to catch up, the extra
+time is dropped - the game slows down, rather than each frame taking longer to
+simulate than the last.
+*/
 void PhysicsSystem::Update(float dt) {	
+	dTOffset += std::min(dt, fixedDeltaTime * maxSubsteps);
 
-	dTOffset += dt;
-
-	GameTimer t;
-	t.GetTimeDeltaSeconds();
+	int stepCount = std::min((int)(dTOffset / fixedDeltaTime), maxSubsteps);
+	if (stepCount > 0) {
+		GatherBodies();
 
-	if (useBroadPhase) 
-		UpdateObjectAABBs();
-	
-	int iteratorCount = 0;
+		if (broadPhaseMode == BroadPhaseMode::QuadTree) 
+			UpdateObjectAABBs();
+		else if (broadPhaseMode == BroadPhaseMode::SweepAndPrune)
+			gameWorld.GetSweepAndPrune().SelectDominantAxis();
+	}
 
-	while(dTOffset > realDT) {
-		IntegrateAccel(realDT); 
-		if (useBroadPhase) {
+	for (int step = 0; step < stepCount; ++step) {
+		IntegrateAccel(fixedDeltaTime); 
+		//The world's queries walk the tree too, so it's kept up to date whichever broadphase is in use
+		UpdateBroadphaseTree(fixedDeltaTime);
+		if (broadPhaseMode == BroadPhaseMode::QuadTree) {
 			BroadPhase();
-			NarrowPhase();
+		}
+		else if (broadPhaseMode == BroadPhaseMode::DynamicTree) {
+			TreeBroadPhase();
+		}
+		else if (broadPhaseMode == BroadPhaseMode::SweepAndPrune) {
+			UpdateSweepAndPrune();
+			SweepBroadPhase();
 		}
 		else 
 			BasicCollisionDetection();
+		NarrowPhase();
 
-		float constraintDt = realDT /  (float)constraintIterationCount;
+		//Contacts and constraints are solved together, so they can settle against each other
+		float constraintDt = fixedDeltaTime /  (float)constraintIterationCount;
+		PreSolveContacts(fixedDeltaTime);
 		for (int i = 0; i < constraintIterationCount; ++i) {
+			SolveContacts();
 			UpdateConstraints(constraintDt);	
 		}
-		IntegrateVelocity(realDT);
+		FindTimesOfImpact(fixedDeltaTime);
+		IntegrateVelocity(fixedDeltaTime);
+		ApplyTimesOfImpact();
+		PhysicsBodyStore::Instance().WriteTransforms();
+		UpdateSleeping(fixedDeltaTime);
 
-		dTOffset -= realDT;
-		iteratorCount++;
+		dTOffset -= fixedDeltaTime;
+	}
+	if (dTOffset >= fixedDeltaTime) {
+		dTOffset = std::fmod(dTOffset, fixedDeltaTime);
 	}
 
-	ClearForces();	
-	UpdateCollisionList(); 
+	//Forces added on frames without a step are kept for the next one
+	if (stepCount > 0) {
+		ClearForces();
+		UpdateCollisionList(); 
+	}
+	Transform::SetRenderInterpolation(dTOffset / fixedDeltaTime);
+}
 
-	t.Tick();
-	float updateTime = t.GetTimeDeltaSeconds();
+/*
+One pass over the cache finds every event for the frame. Each contact in the
+narrowphase puts its pair's frame count back to the top, so a pair only ends
+once it's gone that many frames without touching. Pairs that have gone to
+sleep are left as they are until they wake. Walking backwards lets ended pairs
+be removed as they're found. Nothing is told about the events until
+DispatchCollisionEvents.
+*/
+void PhysicsSystem::UpdateCollisionList() {
+	for (int i = allCollisions.Size() - 1; i >= 0; --i) {
+		CollisionRecord& c = allCollisions.GetEntry(i).value;
+		//Pairs with an object that's left the world are ended at the end of the frame
+		if (!gameWorld.GetBoundsComponent(c.aHandle) || !gameWorld.GetBoundsComponent(c.bHandle)) {
+			continue;
+		}
+		if (!c.begun) {
+			c.begun = true;
+			collisionEvents.emplace_back(CollisionEvent::Begin, c.a, c.b);
+			c.framesLeft--;
+			continue;
+		}
+		//Sleeping pairs aren't tested any more, but they're still touching
+		if (!IsActiveBounds(c.a) && !IsActiveBounds(c.b)) {
+			continue;
+		}
+		if (c.framesLeft == numCollisionFrames) {
+			collisionEvents.emplace_back(CollisionEvent::Stay, c.a, c.b);
+		}
 
-	if (updateTime > realDT) {
-		realHZ /= 2;
-		realDT *= 2;
-	}
-	else if(dt*2 < realDT) { 
-		int temp = realHZ;
-		realHZ *= 2;
-		realDT /= 2;
+		c.framesLeft--;
 
-		if (realHZ > idealHZ) {
-			realHZ = idealHZ;
-			realDT = idealDT;
+		if (c.framesLeft < 0) {
+			collisionEvents.emplace_back(CollisionEvent::End, c.a, c.b);
+			allCollisions.RemoveAt(i);
 		}
 	}
 }
 
-void PhysicsSystem::UpdateCollisionList() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
-		if ((*i).framesLeft == numCollisionFrames) {
-			i->a->GetGameObject().OnCollisionBegin(i->b);
-			i->b->GetGameObject().OnCollisionBegin(i->a);
+/*
+Run by the world as it flushes removed objects, while they're still in memory.
+A pair that has lost an object ends there and then, so whatever's left is told
+it's stopped touching, and woken if it was asleep against it - a stack on a
+removed floor has to fall. Pairs that never got to begin just go.
+*/
+void PhysicsSystem::EndDepartedCollisions() {
+	for (int i = allCollisions.Size() - 1; i >= 0; --i) {
+		CollisionRecord& c = allCollisions.GetEntry(i).value;
+		BoundsComponent* a = gameWorld.GetBoundsComponent(c.aHandle);
+		BoundsComponent* b = gameWorld.GetBoundsComponent(c.bHandle);
+		if (a && b) {
+			continue;
 		}
+		BoundsComponent* survivor = a ? a : b;
+		if (survivor && IsDynamicBounds(survivor)) {
+			survivor->GetPhysicsComponent()->GetPhysicsObject()->WakeUp();
+		}
+		if (c.begun) {
+			collisionEvents.emplace_back(CollisionEvent::End, c.a, c.b);
+		}
+		allCollisions.RemoveAt(i);
+	}
+	DispatchCollisionEvents();
+}
 
-		CollisionDetection::CollisionInfo& in = const_cast<CollisionDetection::CollisionInfo&>(*i);
-		in.framesLeft--;
-
-		if ((*i).framesLeft < 0) {
-			i->a->GetGameObject().OnCollisionEnd(i->b);
-			i->b->GetGameObject().OnCollisionEnd(i->a);
-			i = allCollisions.erase(i);
+/*
+Each event goes to both objects, then to the listeners of each layer involved -
+once, if both objects are on the same layer.
+*/
+void PhysicsSystem::DispatchCollisionEvents() {
+	for (const CollisionEvent& e : collisionEvents) {
+		GameObject& a = e.GetBoundsA()->GetGameObject();
+		GameObject& b = e.GetBoundsB()->GetGameObject();
+		switch (e.GetPhase()) {
+			case CollisionEvent::Begin:
+				a.OnCollisionBegin(e.GetBoundsB());
+				b.OnCollisionBegin(e.GetBoundsA());
+				break;
+			case CollisionEvent::Stay:
+				a.OnCollisionStay(e.GetBoundsB());
+				b.OnCollisionStay(e.GetBoundsA());
+				break;
+			case CollisionEvent::End:
+				a.OnCollisionEnd(e.GetBoundsB());
+				b.OnCollisionEnd(e.GetBoundsA());
+				break;
 		}
-		else {
-			++i;
+		CallLayerCollisionListeners(e.GetLayerA(), e);
+		if (e.GetLayerB() != e.GetLayerA()) {
+			CallLayerCollisionListeners(e.GetLayerB(), e);
 		}
 	}
+	collisionEvents.clear();
 }
 
 void PhysicsSystem::UpdateObjectAABBs() {
-	std::vector<BoundsComponent*>::const_iterator first;
-	std::vector<BoundsComponent*>::const_iterator last;
-	gameWorld.GetBoundsIterators(first, last);
-	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateBroadphaseAABB();
+	gameWorld.Each<BoundsComponent>([](GameObject&, BoundsComponent& bounds) {
+		bounds.UpdateBroadphaseAABB();
+	});
+}
+
+/*
+The pair is stored with the lower world ID first, which is the order the
+narrowphase and the contact manifolds expect. Broadphases that can find the
+same pair more than once only keep the first.
+*/
+void PhysicsSystem::AddBroadphasePair(BoundsComponent* a, BoundsComponent* b) {
+	int aID = a->GetGameObject().GetWorldID();
+	int bID = b->GetGameObject().GetWorldID();
+
+	bool added;
+	CollisionDetection::CollisionInfo& info = broadphaseCollisions.Insert(PairCache<CollisionDetection::CollisionInfo>::MakeKey(aID, bID), added);
+	if (added) {
+		info.a = aID < bID ? a : b;
+		info.b = aID < bID ? b : a;
 	}
 }
 
+/*
+Brute force broadphase - every pair of objects with physics goes on to the
+narrowphase.
+*/
 void PhysicsSystem::BasicCollisionDetection() {
+	broadphaseCollisions.Clear();
+
 	std::vector<BoundsComponent*>::const_iterator first;
 	std::vector<BoundsComponent*>::const_iterator last;
 	gameWorld.GetBoundsIterators(first, last);
 
 	for (auto i = first; i != last; ++i) {
-		if ((*i)->GetPhysicsComponent() == nullptr) {
+		if ((*i)->GetPhysicsComponent() == nullptr || (*i)->GetPhysicsComponent()->GetPhysicsObject() == nullptr) {
 			continue;
 		}
 		for (auto j = i + 1; j != last; ++j) {
-			if ((*j)->GetPhysicsComponent() == nullptr) {
+			if ((*j)->GetPhysicsComponent() == nullptr || (*j)->GetPhysicsComponent()->GetPhysicsObject() == nullptr) {
 				continue;
 			}
-			CollisionDetection::CollisionInfo info;
-			if (CollisionDetection::ObjectIntersection(*i, *j, info)) 
-			{
-				ImpulseResolveCollision(*info.a, *info.b, info.point);
-				info.framesLeft = numCollisionFrames;
-				allCollisions.insert(info);
+			if (!CanCollide(**i, **j)) {
+				continue;
 			}
+			AddBroadphasePair(*i, *j);
 		}
 	}
 }
 
-void PhysicsSystem::ImpulseResolveCollision(BoundsComponent& a, BoundsComponent& b, CollisionDetection::ContactPoint& p) const {
-	GameObject& aObject = a.GetGameObject();
-	GameObject& bObject = b.GetGameObject();
+/*
+Pairs that fail this are dropped before the narrowphase, so they never report
+collisions at all. The layer matrix covers whole layers, and the category and
+mask bits let individual volumes opt out of each other.
+*/
+bool PhysicsSystem::CanCollide(const BoundsComponent& a, const BoundsComponent& b) const {
+	if (!a.PassesCollisionFilter(b)) {
+		return false;
+	}
+	return LayersCollide(a.GetGameObject().GetLayerID(), b.GetGameObject().GetLayerID());
+}
 
+/*
+Triggers, objects on layers that ignore each other, and pairs where neither
+object can move still report collisions, but are never pushed apart.
+*/
+bool PhysicsSystem::HasCollisionResponse(const BoundsComponent& a, const BoundsComponent& b) const {
 	auto layerID = Layers::Ignore_Collisions;
-	auto aLayerID = aObject.GetLayerID();
-	auto bLayerID = bObject.GetLayerID();
+	auto aLayerID = a.GetGameObject().GetLayerID();
+	auto bLayerID = b.GetGameObject().GetLayerID();
 
 	if (aLayerID == layerID || bLayerID == layerID)
-		return;
+		return false;
 
 	if (a.GetBoundingVolume()->isTrigger || b.GetBoundingVolume()->isTrigger)
-		return;
-
-	for (const auto& layer : a.GetIgnoredLayers()) {
-		if (bLayerID == layer)
-			return;
-	}
+		return false;
 
-	for (const auto& layer : b.GetIgnoredLayers()) {
-		if (aLayerID == layer)
-			return;
-	}
+	if ((a.GetIgnoredLayers() & Layers::ToMask(bLayerID)) || (b.GetIgnoredLayers() & Layers::ToMask(aLayerID)))
+		return false;
 
-	PhysicsObject* physA = a.GetPhysicsComponent()->GetPhysicsObject();
-	PhysicsObject* physB = b.GetPhysicsComponent()->GetPhysicsObject();
+	const PhysicsObject* physA = a.GetPhysicsComponent()->GetPhysicsObject();
+	const PhysicsObject* physB = b.GetPhysicsComponent()->GetPhysicsObject();
 
-	Transform& transformA = aObject.GetTransform();
-	Transform& transformB = bObject.GetTransform();
-
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
-
-	if (totalMass == 0) 
-		return; 
-
-	transformA.SetPosition(transformA.GetPosition() - (p.normal * p.penetration * (physA->GetInverseMass() / totalMass)));
-	transformB.SetPosition(transformB.GetPosition() + (p.normal * p.penetration * (physB->GetInverseMass() / totalMass)));
-
-	Vector3 relativeA = p.localA;
-	Vector3 relativeB = p.localB;
-
-	Vector3 angVelocityA = Vector::Cross(physA->GetAngularVelocity(), relativeA);
-	Vector3 angVelocityB = Vector::Cross(physB->GetAngularVelocity(), relativeB);
-
-	Vector3 fullVelocityA = physA->GetLinearVelocity() + angVelocityA;
-	Vector3 fullVelocityB = physB->GetLinearVelocity() + angVelocityB;
-
-	Vector3 contactVelocity = fullVelocityB - fullVelocityA;	
-	float cFriction = (physA->GetFriction() + physB->GetFriction()) / 2;
-	contactVelocity *= cFriction;
-	float impulseForce = Vector::Dot(contactVelocity, p.normal);
-
-	Vector3 inertiaA = Vector::Cross(physA->GetInertiaTensor() * Vector::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector::Cross(physB->GetInertiaTensor() * Vector::Cross(relativeB, p.normal), relativeB);
-	float angularEffect = Vector::Dot(inertiaA + inertiaB, p.normal);
-
-	float cRestitution = physA->GetRestitution() + physB->GetRestitution();
-
-	if (cRestitution > 0)
-		cRestitution /= 2;
-
-	float j = (-(1.0f + cRestitution) * impulseForce) / (totalMass + angularEffect);
-
-
-	Vector3 fullImpulse = (p.normal * j);
-
-	physA->ApplyLinearImpulse(-fullImpulse);
-	physB->ApplyLinearImpulse(fullImpulse);
-
-	physA->ApplyAngularImpulse(Vector::Cross(relativeA, -fullImpulse));
-	physB->ApplyAngularImpulse(Vector::Cross(relativeB, fullImpulse));
+	return physA->GetInverseMass() + physB->GetInverseMass() > 0.0f;
 }
 
 
 void PhysicsSystem::BroadPhase() {
-	broadphaseCollisions.clear();
+	broadphaseCollisions.Clear();
 	QuadTree<BoundsComponent*> tree(Vector2(1024, 1024), 7, 6);
 
 	std::vector<BoundsComponent*>::const_iterator first;
@@ -262,113 +340,491 @@ void PhysicsSystem::BroadPhase() {
 	}
 	tree.OperateOnContents([&](std::list<QuadTreeEntry<BoundsComponent*>>& data) 
 	{
-		CollisionDetection::CollisionInfo info;
 		for (auto i = data.begin(); i != data.end(); ++i) 
 		{
 			for (auto j = std::next(i); j != data.end(); ++j) 
 			{
-				info.a = std::min((*i).object, (*j).object);
-				info.b = std::max((*i).object, (*j).object);
-				broadphaseCollisions.insert(info);
+				if (!CanCollide(*(*i).object, *(*j).object)) {
+					continue;
+				}
+				AddBroadphasePair((*i).object, (*j).object);
 			}
 		}
 	});
 }
 
-void PhysicsSystem::NarrowPhase() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i) {
-		CollisionDetection::CollisionInfo info = *i;
-		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
-			info.framesLeft = numCollisionFrames;
-			ImpulseResolveCollision(*info.a, *info.b, info.point);
-			allCollisions.insert(info); // insert into our main set
-		}
+bool PhysicsSystem::IsDynamicBounds(const BoundsComponent* b) const {
+	const PhysicsComponent* phys = b->GetPhysicsComponent();
+	if (!phys || !phys->GetPhysicsObject()) {
+		return false;
 	}
+	return phys->GetPhysicsObject()->GetInverseMass() > 0.0f;
 }
 
-void PhysicsSystem::IntegrateAccel(float dt)
-{
-	std::vector<PhysicsComponent*>::const_iterator first;
-	std::vector<PhysicsComponent*>::const_iterator last;
-	gameWorld.GetPhysicsIterators(first, last);
+//Dynamic objects that haven't been put to sleep
+bool PhysicsSystem::IsActiveBounds(const BoundsComponent* b) const {
+	return IsDynamicBounds(b) && b->GetPhysicsComponent()->GetPhysicsObject()->IsAwake();
+}
+
+/*
+Awake bodies are refit every step, with their boxes stretched along their
+velocity. Anything else is only refit if its transform has been set since the
+last frame was drawn - static and sleeping objects otherwise stay where they
+were left.
+*/
+void PhysicsSystem::UpdateBroadphaseTree(float dt) {
+	DynamicAABBTree<BoundsComponent*>& tree = gameWorld.GetBroadphaseTree();
+
+	gameWorld.Each<BoundsComponent>([&](GameObject& o, BoundsComponent& bounds) {
+		int proxy = bounds.GetBroadphaseProxy();
+		if (proxy == DynamicAABBTree<BoundsComponent*>::NullNode) {
+			return;
+		}
+		bool active = IsActiveBounds(&bounds);
+		if (!active && !o.GetTransform().IsDirty()) {
+			return;
+		}
+		bounds.UpdateBroadphaseAABB();
+		Vector3 displacement = active ? bounds.GetPhysicsComponent()->GetPhysicsObject()->GetLinearVelocity() * dt : Vector3();
+		tree.Move(proxy, bounds.GetWorldBounds(), displacement);
+	});
+}
+
+/*
+Static and sleeping objects never start a query, so pairs where neither object
+can move are never generated, and the cost of the broadphase follows the number
+of moving objects. When both objects in a pair are moving, only the lower
+addressed one reports it.
+*/
+void PhysicsSystem::TreeBroadPhase() {
+	broadphaseCollisions.Clear();
+	const DynamicAABBTree<BoundsComponent*>& tree = gameWorld.GetBroadphaseTree();
+
+	std::vector<BoundsComponent*>::const_iterator first;
+	std::vector<BoundsComponent*>::const_iterator last;
+	gameWorld.GetBoundsIterators(first, last);
 
 	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue; 
+		BoundsComponent* self = *i;
+		int proxy = self->GetBroadphaseProxy();
+		if (proxy == DynamicAABBTree<BoundsComponent*>::NullNode || !IsActiveBounds(self)) {
+			continue;
 		}
-		float inverseMass = object->GetInverseMass();
+		tree.Query(tree.GetFatBounds(proxy), [&](BoundsComponent* other) {
+			if (other == self || !other->GetPhysicsComponent() || !other->GetPhysicsComponent()->GetPhysicsObject()) {
+				return true;
+			}
+			if (other < self && IsActiveBounds(other)) {
+				return true;
+			}
+			if (!CanCollide(*self, *other)) {
+				return true;
+			}
+			AddBroadphasePair(self, other);
+			return true;
+		});
+	}
+}
 
-		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
-		Vector3 accel = force * inverseMass;
+/*
+As with the tree, static objects keep the bounds they were inserted with. The
+endpoints are then re-sorted in place, which is cheap as they've barely moved
+since the last step.
+*/
+void PhysicsSystem::UpdateSweepAndPrune() {
+	SweepAndPrune<BoundsComponent*>& sweep = gameWorld.GetSweepAndPrune();
+
+	gameWorld.Each<BoundsComponent>([&](GameObject&, BoundsComponent& bounds) {
+		int proxy = bounds.GetSweepProxy();
+		if (proxy == SweepAndPrune<BoundsComponent*>::NullProxy || !IsActiveBounds(&bounds)) {
+			return;
+		}
+		bounds.UpdateBroadphaseAABB();
+		sweep.Update(proxy, bounds.GetWorldBounds());
+	});
+	sweep.Sort();
+}
 
-		if (applyGravity && inverseMass > 0) 
-			accel += gravity; 
-		
+/*
+The sweep finds every overlapping pair, so pairs where neither object is moving,
+or where either lacks a physics object, are thrown away here.
+*/
+void PhysicsSystem::SweepBroadPhase() {
+	broadphaseCollisions.Clear();
 
-		linearVel += accel * dt; 
-		object->SetLinearVelocity(linearVel);
+	gameWorld.GetSweepAndPrune().FindPairs([&](BoundsComponent* a, BoundsComponent* b) {
+		if (!a->GetPhysicsComponent() || !a->GetPhysicsComponent()->GetPhysicsObject() ||
+			!b->GetPhysicsComponent() || !b->GetPhysicsComponent()->GetPhysicsObject()) {
+			return;
+		}
+		if (!IsActiveBounds(a) && !IsActiveBounds(b)) {
+			return;
+		}
+		if (!CanCollide(*a, *b)) {
+			return;
+		}
+		AddBroadphasePair(a, b);
+	});
+}
+
+/*
+Contacts are ordered by the world IDs of the objects involved rather than by
+address, so they're resolved in the same order on every run, and on every
+machine.
+*/
+static bool ContactOrder(const CollisionDetection::CollisionInfo& x, const CollisionDetection::CollisionInfo& y) {
+	int xa = x.a->GetGameObject().GetWorldID();
+	int ya = y.a->GetGameObject().GetWorldID();
+	if (xa != ya) {
+		return xa < ya;
+	}
+	return x.b->GetGameObject().GetWorldID() < y.b->GetGameObject().GetWorldID();
+}
 
-		Vector3 torque = object ->GetTorque();
-		Vector3 angVel = object->GetAngularVelocity();
+/*
+The intersection tests only read the transforms and volumes of the objects,
+so they're run across the job system, each pair writing only to its own slot.
+Resolution moves objects, so it's done afterwards on this thread.
+*/
+void PhysicsSystem::NarrowPhase() {
+	broadphaseCollisionsVec.clear();
+	for (int i = 0; i < broadphaseCollisions.Size(); ++i) {
+		const CollisionDetection::CollisionInfo& pair = broadphaseCollisions.GetEntry(i).value;
+		//Nothing can change between objects that are both asleep or static
+		if (IsActiveBounds(pair.a) || IsActiveBounds(pair.b)) {
+			broadphaseCollisionsVec.push_back(pair);
+		}
+	}
+	int pairCount = (int)broadphaseCollisionsVec.size();
+	narrowphaseHits.resize(pairCount);
+
+	JobSystem::Instance().ParallelFor(pairCount, 32, [&](int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			CollisionDetection::CollisionInfo& pair = broadphaseCollisionsVec[i];
+			narrowphaseHits[i] = CollisionDetection::ObjectIntersection(pair.a, pair.b, pair) ? 1 : 0;
+		}
+	});
+
+	narrowphaseContacts.clear();
+	for (int i = 0; i < pairCount; ++i) {
+		if (narrowphaseHits[i]) {
+			narrowphaseContacts.push_back(broadphaseCollisionsVec[i]);
+		}
+	}
+	std::sort(narrowphaseContacts.begin(), narrowphaseContacts.end(), ContactOrder);
+
+	for (auto& m : contactManifolds) {
+		m.second.SetUpdated(false);
+	}
+	for (CollisionDetection::CollisionInfo& info : narrowphaseContacts) {
+		bool added;
+		int aID = info.a->GetGameObject().GetWorldID();
+		int bID = info.b->GetGameObject().GetWorldID();
+		CollisionRecord& record = allCollisions.Insert(PairCache<CollisionRecord>::MakeKey(aID, bID), added);
+		if (added) {
+			record.a		= info.a;
+			record.b		= info.b;
+			record.aHandle	= info.a->GetWorldHandle();
+			record.bHandle	= info.b->GetWorldHandle();
+			record.begun	= false;
+		}
+		record.framesLeft = numCollisionFrames;
+
+		if (!HasCollisionResponse(*info.a, *info.b)) {
+			continue;
+		}
+		//Anything sleeping that's hit by a moving object has to wake up to respond
+		PhysicsObject* physA = info.a->GetPhysicsComponent()->GetPhysicsObject();
+		PhysicsObject* physB = info.b->GetPhysicsComponent()->GetPhysicsObject();
+		if (physA->GetInverseMass() > 0.0f) {
+			physA->WakeUp();
+		}
+		if (physB->GetInverseMass() > 0.0f) {
+			physB->WakeUp();
+		}
+		std::pair<int, int> key(info.a->GetGameObject().GetWorldID(), info.b->GetGameObject().GetWorldID());
+		auto m = contactManifolds.try_emplace(key, info.a, info.b).first;
+		if (!m->second.WasUpdated()) {
+			m->second.Refresh();
+			m->second.SetUpdated(true);
+		}
+		m->second.AddContact(info.point);
+	}
+	//Pairs that are no longer touching lose their manifold - the objects may not even exist any more
+	for (auto m = contactManifolds.begin(); m != contactManifolds.end(); ) {
+		if (m->second.WasUpdated()) {
+			++m;
+		}
+		else {
+			m = contactManifolds.erase(m);
+		}
+	}
+}
 
-		object->UpdateInertiaTensor();
+void PhysicsSystem::PreSolveContacts(float dt) {
+	for (auto& m : contactManifolds) {
+		m.second.PreSolve(dt);
+		m.second.WarmStart();
+	}
+}
 
-		Vector3 angAccel = object->GetInertiaTensor() * torque;
-		angVel += angAccel * dt;
-		object->SetAngularVelocity(angVel);
+void PhysicsSystem::SolveContacts() {
+	for (auto& m : contactManifolds) {
+		m.second.Solve();
 	}
 }
 
+void PhysicsSystem::IntegrateAccel(float dt)
+{
+	PhysicsBodyStore::Instance().IntegrateAccel(dt, applyGravity ? gravity : Vector3());
+}
+
+/*
+Positions and orientations are integrated in the body store, and only copied
+out to the transforms once anything swept has been held back.
+*/
 void PhysicsSystem::IntegrateVelocity(float dt) {
-	std::vector<PhysicsComponent*>::const_iterator first;
-	std::vector<PhysicsComponent*>::const_iterator last;
-	gameWorld.GetPhysicsIterators(first, last);
+	float frameLinearDamping	= 1.0f - (0.4f * dt);
+	float frameAngularDamping	= 1.0f - (0.4f * dt);
+
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.IntegrateVelocity(dt, frameLinearDamping, frameAngularDamping);
+	store.UpdateInertiaTensors(true);
+}
+
+/*
+Swept objects are stood in for by spheres inside their volume - the volume
+itself for spheres, a row of spheres along the core of a capsule, and the
+largest sphere that fits inside a box. Anything that would stop those spheres
+can't be passed through.
+*/
+static float GetSweepSpheres(const CollisionVolume& volume, const Transform& transform, std::vector<Vector3>& centres) {
+	centres.clear();
+	Vector3 position = transform.GetPosition();
+
+	if (volume.type == VolumeType::Sphere) {
+		centres.push_back(position);
+		return ((const SphereVolume&)volume).GetRadius();
+	}
+	if (volume.type == VolumeType::Capsule) {
+		const CapsuleVolume& capsule = (const CapsuleVolume&)volume;
+		float radius	= capsule.GetRadius();
+		Vector3 axis	= transform.GetOrientation() * Vector3(0, capsule.GetHalfHeight(), 0);
+		int segments	= std::max(1, (int)std::ceil(2.0f * capsule.GetHalfHeight() / radius));
+		for (int i = 0; i <= segments; ++i) {
+			centres.push_back(position - axis + axis * (2.0f * i / segments));
+		}
+		return radius;
+	}
+	if (volume.type == VolumeType::AABB) {
+		centres.push_back(position);
+		return Vector::GetMinElement(((const AABBVolume&)volume).GetHalfDimensions());
+	}
+	if (volume.type == VolumeType::OBB) {
+		centres.push_back(position);
+		return Vector::GetMinElement(((const OBBVolume&)volume).GetHalfDimensions());
+	}
+	return 0.0f;
+}
+
+/*
+Objects flagged for continuous collision that will move further than their
+sweep radius this step are swept against the static objects along their path,
+found using the broadphase tree. Those that would hit something are stopped
+just inside it after their velocity has been integrated, so the next step's
+narrowphase finds the contact and the solver handles it as normal. Moving
+against other moving objects is left to the fixed step.
+*/
+void PhysicsSystem::FindTimesOfImpact(float dt) {
+	const float sweepPenetration = 0.02f;
 
-	float frameLinearDamping = 1.0f - (0.4f * dt);
+	timesOfImpact.clear();
+	const DynamicAABBTree<BoundsComponent*>& tree = gameWorld.GetBroadphaseTree();
+
+	std::vector<BoundsComponent*>::const_iterator first;
+	std::vector<BoundsComponent*>::const_iterator last;
+	gameWorld.GetBoundsIterators(first, last);
 
 	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
+		BoundsComponent* self = *i;
+		if (!self->GetBoundingVolume() || !IsActiveBounds(self)) {
+			continue;
+		}
+		PhysicsObject* object = self->GetPhysicsComponent()->GetPhysicsObject();
+		if (!object->UsesContinuousCollision()) {
+			continue;
+		}
+		Transform& transform = self->GetGameObject().GetTransform();
 
-		if (object == nullptr) 
+		float radius	= GetSweepSpheres(*self->GetBoundingVolume(), transform, sweepCentres);
+		Vector3 motion	= object->GetLinearVelocity() * dt;
+		if (radius <= 0.0f || Vector::LengthSquared(motion) <= radius * radius) {
 			continue;
+		}
+		float sweepRadius = std::max(radius - sweepPenetration, 0.0f);
 
-		Transform& transform = (*i)->GetGameObject().GetTransform();
+		self->UpdateBroadphaseAABB();
+		BoundingBox start	= self->GetWorldBounds();
+		BoundingBox path	= BoundingBox::Combine(start, BoundingBox(start.min + motion, start.max + motion));
 
-		Vector3 position = transform.GetPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
-		position += linearVel * dt;
-		transform.SetPosition(position);
+		TimeOfImpact impact;
+		impact.toi = 1.0f;
+		tree.Query(path, [&](BoundsComponent* other) {
+			if (other == self || !other->GetBoundingVolume() || IsDynamicBounds(other)) {
+				return true;
+			}
+			if (!other->GetPhysicsComponent() || !other->GetPhysicsComponent()->GetPhysicsObject() || !CanCollide(*self, *other) || !HasCollisionResponse(*self, *other)) {
+				return true;
+			}
+			const Transform& otherTransform = other->GetGameObject().GetTransform();
+			for (const Vector3& centre : sweepCentres) {
+				float	toi;
+				Vector3 normal;
+				if (CollisionDetection::SphereTimeOfImpact(centre, motion, sweepRadius, *other->GetBoundingVolume(), otherTransform, toi, normal) && toi < impact.toi) {
+					impact.toi		= toi;
+					impact.normal	= normal;
+				}
+			}
+			return true;
+		});
+		if (impact.toi < 1.0f) {
+			impact.bounds	= self;
+			impact.position = transform.GetPosition() + motion * impact.toi;
+			timesOfImpact.push_back(impact);
+		}
+	}
+}
 
-		linearVel = linearVel * frameLinearDamping;
-		//linearVel *= object->GetFriction();
+/*
+Only the body store is moved, the transforms are written along with everything
+else. Velocities are normally left alone, as it's up to the contact solver to stop
+the object. An object that couldn't move at all was already touching last step
+without the solver stopping it, so it has its velocity into the surface removed
+rather than being held in place forever.
+*/
+void PhysicsSystem::ApplyTimesOfImpact() {
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	for (const TimeOfImpact& impact : timesOfImpact) {
+		PhysicsObject* object = impact.bounds->GetPhysicsComponent()->GetPhysicsObject();
+		store.SetPosition(object->GetBodyIndex(), impact.position);
+
+		if (impact.toi <= 0.0f) {
+			Vector3 velocity = object->GetLinearVelocity();
+			object->SetLinearVelocity(velocity - impact.normal * std::min(Vector::Dot(velocity, impact.normal), 0.0f));
+		}
+	}
+}
 
-		object->SetLinearVelocity(linearVel);
+/*
+Marks which bodies in the store belong to this world, and pulls in their
+transforms, as gameplay code may have moved them since the last update.
+*/
+void PhysicsSystem::GatherBodies() {
+	PhysicsBodyStore& store = PhysicsBodyStore::Instance();
+	store.BeginGather();
+
+	gameWorld.Each<PhysicsComponent>([&](GameObject&, PhysicsComponent& phys) {
+		PhysicsObject* object = phys.GetPhysicsObject();
+		if (object) {
+			store.GatherBody(object->GetBodyIndex());
+		}
+	});
+	store.UpdateInertiaTensors(false);
+}
 
-		Quaternion orientation = transform.GetOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
+/*
+Groups the awake objects into islands - sets of objects touching each other,
+or tied together by constraints - and puts any island to sleep once every
+object in it has been moving slowly for long enough. Static objects hold
+islands up without joining them, and never sleep themselves - there's nothing
+to save on something that never moves, and a sleeping static would only wake
+itself when removed, not whatever was resting on it.
+*/
+void PhysicsSystem::UpdateSleeping(float dt) {
+	if (!useSleeping) {
+		return;
+	}
+	std::vector<PhysicsComponent*>::const_iterator first;
+	std::vector<PhysicsComponent*>::const_iterator last;
+	gameWorld.GetPhysicsIterators(first, last);
 
-		orientation = orientation +
-			(Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
-		orientation.Normalise();
+	islandBodies.clear();
+	for (auto i = first; i != last; ++i) {
+		PhysicsObject* object = (*i)->GetPhysicsObject();
+		if (object == nullptr || !object->IsAwake() || object->GetInverseMass() == 0.0f) {
+			continue;
+		}
+		object->UpdateSleepTimer(dt, sleepLinearThreshold, sleepAngularThreshold);
+		object->SetIslandIndex((int)islandBodies.size());
+		islandBodies.push_back(object);
+	}
+	int bodyCount = (int)islandBodies.size();
+	islandParents.resize(bodyCount);
+	for (int i = 0; i < bodyCount; ++i) {
+		islandParents[i] = i;
+	}
 
-		transform.SetOrientation(orientation);
+	auto join = [&](PhysicsObject* a, PhysicsObject* b) {
+		if (!a || !b || a->GetInverseMass() == 0.0f || b->GetInverseMass() == 0.0f) {
+			return;
+		}
+		if (!a->IsAwake() || !b->IsAwake()) { //Picked up next step, once both are awake
+			a->WakeUp();
+			b->WakeUp();
+			return;
+		}
+		islandParents[FindIsland(a->GetIslandIndex())] = FindIsland(b->GetIslandIndex());
+	};
+	for (auto& m : contactManifolds) {
+		join(m.second.GetBoundsA()->GetPhysicsComponent()->GetPhysicsObject(),
+			 m.second.GetBoundsB()->GetPhysicsComponent()->GetPhysicsObject());
+	}
+	std::vector<Constraint*>::const_iterator firstConstraint;
+	std::vector<Constraint*>::const_iterator lastConstraint;
+	gameWorld.GetConstraintIterators(firstConstraint, lastConstraint);
+	for (auto i = firstConstraint; i != lastConstraint; ++i) {
+		join((*i)->GetPhysicsObjectA(), (*i)->GetPhysicsObjectB());
+	}
 
-		float frameAngularDamping = 1.0f - (0.4f * dt);
-		angVel = angVel * frameAngularDamping;
-		object->SetAngularVelocity(angVel);
+	//An island sleeps only when its most recently moving object is ready to
+	islandSleepTimes.assign(bodyCount, FLT_MAX);
+	for (int i = 0; i < bodyCount; ++i) {
+		int root = FindIsland(i);
+		islandSleepTimes[root] = std::min(islandSleepTimes[root], islandBodies[i]->GetSleepTimer());
+	}
+	islandFirst.assign(bodyCount, -1);
+	islandLast.assign(bodyCount, -1);
+	for (int i = 0; i < bodyCount; ++i) {
+		int root = FindIsland(i);
+		if (islandSleepTimes[root] < timeToSleep || !islandBodies[i]->IsAwake()) {
+			continue;
+		}
+		if (islandFirst[root] < 0) {
+			islandFirst[root] = i;
+		}
+		else {
+			islandBodies[islandLast[root]]->Sleep(islandBodies[i]);
+		}
+		islandLast[root] = i;
+	}
+	//Close each ring back on itself
+	for (int i = 0; i < bodyCount; ++i) {
+		if (islandFirst[i] >= 0) {
+			islandBodies[islandLast[i]]->Sleep(islandBodies[islandFirst[i]]);
+		}
+	}
+}
 
+int PhysicsSystem::FindIsland(int i) {
+	while (islandParents[i] != i) {
+		islandParents[i] = islandParents[islandParents[i]];
+		i = islandParents[i];
 	}
+	return i;
 }
 
 void PhysicsSystem::ClearForces() {
-	gameWorld.OperateOnPhysicsContents(
-		[](PhysicsComponent* o) {
-			if (o->GetPhysicsObject())
-				o->GetPhysicsObject()->ClearForces();
-		}
-	);
+	PhysicsBodyStore::Instance().ClearForces();
 }
 
 void PhysicsSystem::UpdateConstraints(float dt) {
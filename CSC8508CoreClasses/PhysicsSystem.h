@@ -1,8 +1,19 @@
 #pragma once
 #include "GameWorld.h"
+#include "JobSystem.h"
+#include "ContactManifold.h"
+#include "PairCache.h"
+#include "CollisionEvent.h"
 
 namespace NCL {
 	namespace CSC8508 {
+		enum class BroadPhaseMode {
+			BruteForce,		//Every pair tested, every step
+			QuadTree,		//Rebuilt from scratch every step
+			DynamicTree,	//Persistent, only moving objects are refit and queried
+			SweepAndPrune	//Persistent sorted endpoints along the most spread out axis
+		};
+
 		class PhysicsSystem	{
 		public:
 			PhysicsSystem(GameWorld& g);
@@ -12,6 +23,9 @@ namespace NCL {
 
 			void Update(float dt);
 
+			//Sends out the collision events buffered by the last Update
+			void DispatchCollisionEvents();
+
 			void UseGravity(bool state) {
 				applyGravity = state;
 			}
@@ -21,35 +35,142 @@ namespace NCL {
 			}
 
 			void SetGravity(const Vector3& g);
+
+			void SetBroadPhaseMode(BroadPhaseMode mode) {
+				broadPhaseMode = mode;
+			}
+
+			BroadPhaseMode GetBroadPhaseMode() const {
+				return broadPhaseMode;
+			}
+
+			void UseSleeping(bool state) {
+				useSleeping = state;
+			}
+
+			void SetFixedTimestep(float stepHZ) {
+				fixedDeltaTime = 1.0f / stepHZ;
+			}
+
+			float GetFixedDeltaTime() const {
+				return fixedDeltaTime;
+			}
+
+			//The most steps one update can run, however far behind it is
+			void SetMaxSubsteps(int steps) {
+				maxSubsteps = std::max(steps, 1);
+			}
+
+			void SetSleepThresholds(float linearSpeed, float angularSpeed, float time) {
+				sleepLinearThreshold	= linearSpeed;
+				sleepAngularThreshold	= angularSpeed;
+				timeToSleep				= time;
+			}
+
+			//Sets whether objects on these two layers can ever collide, in both directions
+			void SetLayerCollision(Layers::LayerID a, Layers::LayerID b, bool state);
+
+			bool LayersCollide(Layers::LayerID a, Layers::LayerID b) const {
+				return (layerCollisions[a] & Layers::ToMask(b)) != 0;
+			}
 		protected:
 			void BasicCollisionDetection();
 			void BroadPhase();
+			void TreeBroadPhase();
+			void SweepBroadPhase();
 			void NarrowPhase();
 
+			void UpdateBroadphaseTree(float dt);
+			void UpdateSweepAndPrune();
+			bool IsDynamicBounds(const BoundsComponent* b) const;
+			bool IsActiveBounds(const BoundsComponent* b) const;
+
 			void ClearForces();
 			void DebugConstraints();
 
 			void IntegrateAccel(float dt);
 			void IntegrateVelocity(float dt);
+			void GatherBodies();
+
+			void FindTimesOfImpact(float dt);
+			void ApplyTimesOfImpact();
 
 			void UpdateConstraints(float dt);
 
+			void PreSolveContacts(float dt);
+			void SolveContacts();
+
+			void UpdateSleeping(float dt);
+			int  FindIsland(int i);
+
 			void UpdateCollisionList();
+			void EndDepartedCollisions();
 			void UpdateObjectAABBs();
 
-			void ImpulseResolveCollision(BoundsComponent& a , BoundsComponent&b, CollisionDetection::ContactPoint& p) const;
+			void AddBroadphasePair(BoundsComponent* a, BoundsComponent* b);
+
+			bool CanCollide(const BoundsComponent& a, const BoundsComponent& b) const;
+			bool HasCollisionResponse(const BoundsComponent& a, const BoundsComponent& b) const;
 
 			GameWorld& gameWorld;
 
 			bool	applyGravity;
 			Vector3 gravity;
 			float	dTOffset;
+			float	fixedDeltaTime	= 1.0f / 60.0f;
+			int		maxSubsteps		= 5;
 			float	globalDamping;
 
-			std::set<CollisionDetection::CollisionInfo> allCollisions;
-			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
+			//Row i holds the layers that layer i collides with
+			Layers::LayerMask layerCollisions[Layers::MaxLayers];
+
+			/*
+			Every pair that's touching, or stopped touching too recently to have ended.
+			Pairs can outlive their objects, so the handles are checked before the
+			pointers are used.
+			*/
+			struct CollisionRecord {
+				BoundsComponent* a;
+				BoundsComponent* b;
+				SlotHandle	aHandle;
+				SlotHandle	bHandle;
+				int		framesLeft;
+				bool	begun;
+			};
+			//Both keyed on the world IDs of the pair
+			PairCache<CollisionRecord> allCollisions;
+			PairCache<CollisionDetection::CollisionInfo> broadphaseCollisions;
+			std::vector<CollisionEvent> collisionEvents;
 			std::vector<CollisionDetection::CollisionInfo> broadphaseCollisionsVec;
-			bool useBroadPhase		= true;
+			std::vector<char> narrowphaseHits;
+			std::vector<CollisionDetection::CollisionInfo> narrowphaseContacts;
+
+			//Keyed on the world IDs of the pair, so manifolds are always solved in the same order
+			std::map<std::pair<int, int>, ContactManifold> contactManifolds;
+
+			//Where each swept object has to stop this step, to stay in front of what it would have hit
+			struct TimeOfImpact {
+				BoundsComponent* bounds;
+				Vector3 position;
+				Vector3 normal;
+				float	toi;
+			};
+			std::vector<TimeOfImpact> timesOfImpact;
+			std::vector<Vector3> sweepCentres;
+
+			//Scratch space for building islands, kept to avoid allocating every step
+			std::vector<PhysicsObject*> islandBodies;
+			std::vector<int>	islandParents;
+			std::vector<float>	islandSleepTimes;
+			std::vector<int>	islandFirst;
+			std::vector<int>	islandLast;
+
+			bool	useSleeping				= true;
+			float	sleepLinearThreshold	= 0.05f;
+			float	sleepAngularThreshold	= 0.05f;
+			float	timeToSleep				= 0.5f;
+
+			BroadPhaseMode broadPhaseMode = BroadPhaseMode::DynamicTree;
 			int numCollisionFrames	= 5;
 		};
 	}
@@ -55,3 +55,10 @@ void PositionConstraint::UpdateConstraint(float dt) {
     }
 }
 
+PhysicsObject* PositionConstraint::GetPhysicsObjectA() const {
+	return objectA->GetPhysicsObject();
+}
+
+PhysicsObject* PositionConstraint::GetPhysicsObjectB() const {
+	return objectB->GetPhysicsObject();
+}
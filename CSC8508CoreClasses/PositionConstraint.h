@@ -12,6 +12,9 @@ namespace NCL {
 
 			void UpdateConstraint(float dt) override;
 
+			PhysicsObject* GetPhysicsObjectA() const override;
+			PhysicsObject* GetPhysicsObjectB() const override;
+
 		protected:
 			PhysicsComponent* objectA;
 			PhysicsComponent* objectB;
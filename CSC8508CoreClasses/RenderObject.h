@@ -2,6 +2,7 @@
 #include "Texture.h"
 #include "Shader.h"
 #include "Mesh.h"
+#include "ObjectPool.h"
 
 namespace NCL {
 	using namespace NCL::Rendering;
@@ -10,7 +11,7 @@ namespace NCL {
 		class Transform;
 		using namespace Maths;
 
-		class RenderObject
+		class RenderObject : public PoolAllocated<RenderObject>
 		{
 		public:
 			RenderObject(Transform* parentTransform, Mesh* mesh, Texture* tex, Shader* shader);
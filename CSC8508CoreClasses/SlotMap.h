@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Refers to a value in a SlotMap. Each slot counts how many times it has
+		been reused, and a handle keeps the count from when it was made, so once
+		its value is removed the handle just stops finding anything, rather than
+		finding whatever took the slot next. A default handle finds nothing.
+		*/
+		struct SlotHandle {
+			uint32_t index		= 0;
+			uint32_t generation = 0;
+
+			bool operator==(const SlotHandle& other) const {
+				return index == other.index && generation == other.generation;
+			}
+			bool operator!=(const SlotHandle& other) const {
+				return !(*this == other);
+			}
+		};
+
+		/*
+		Values are kept packed together in one array, in no particular order, so
+		systems can walk them straight through. Removing a value moves the last
+		one into its place, so both adding and removing are constant time, and
+		handles go through a slot array that always knows where its value is.
+		*/
+		template<class T>
+		class SlotMap {
+		public:
+			SlotMap() {
+				freeHead = NoSlot;
+			}
+			~SlotMap() {
+			}
+
+			SlotHandle Insert(const T& value) {
+				uint32_t slot;
+				if (freeHead != NoSlot) {
+					slot		= freeHead;
+					freeHead	= slots[slot].valueIndex;
+				}
+				else {
+					slot = (uint32_t)slots.size();
+					slots.push_back({ 1, 0 });
+				}
+				slots[slot].valueIndex = (uint32_t)values.size();
+				values.push_back(value);
+				valueSlots.push_back(slot);
+				return { slot, slots[slot].generation };
+			}
+
+			//Returns false if the handle had already stopped finding anything
+			bool Remove(SlotHandle handle) {
+				if (!Contains(handle)) {
+					return false;
+				}
+				uint32_t index	= slots[handle.index].valueIndex;
+				uint32_t last	= (uint32_t)values.size() - 1;
+				if (index != last) {
+					values[index]		= values[last];
+					valueSlots[index]	= valueSlots[last];
+					slots[valueSlots[index]].valueIndex = index;
+				}
+				values.pop_back();
+				valueSlots.pop_back();
+				FreeSlot(handle.index);
+				return true;
+			}
+
+			bool Contains(SlotHandle handle) const {
+				return handle.index < slots.size() && handle.generation != 0 && slots[handle.index].generation == handle.generation;
+			}
+
+			T* Get(SlotHandle handle) {
+				return Contains(handle) ? &values[slots[handle.index].valueIndex] : nullptr;
+			}
+
+			const T* Get(SlotHandle handle) const {
+				return Contains(handle) ? &values[slots[handle.index].valueIndex] : nullptr;
+			}
+
+			//Every handle made so far stops finding anything
+			void Clear() {
+				for (uint32_t slot : valueSlots) {
+					FreeSlot(slot);
+				}
+				values.clear();
+				valueSlots.clear();
+			}
+
+			int Size() const {
+				return (int)values.size();
+			}
+
+			const std::vector<T>& Values() const {
+				return values;
+			}
+
+			//Swaps two values in the packed array, keeping their handles pointing at them
+			void SwapValues(int a, int b) {
+				std::swap(values[a], values[b]);
+				std::swap(valueSlots[a], valueSlots[b]);
+				slots[valueSlots[a]].valueIndex = a;
+				slots[valueSlots[b]].valueIndex = b;
+			}
+
+		protected:
+			static constexpr uint32_t NoSlot = 0xFFFFFFFF;
+
+			struct Slot {
+				uint32_t generation;
+				uint32_t valueIndex; //The next free slot, while the slot is free
+			};
+
+			void FreeSlot(uint32_t slot) {
+				if (++slots[slot].generation == 0) {
+					slots[slot].generation = 1; //0 is kept for handles that never pointed at anything
+				}
+				slots[slot].valueIndex	= freeHead;
+				freeHead				= slot;
+			}
+
+			std::vector<T>			values;
+			std::vector<uint32_t>	valueSlots; //Which slot points at each value
+			std::vector<Slot>		slots;
+			uint32_t				freeHead;
+		};
+	}
+}
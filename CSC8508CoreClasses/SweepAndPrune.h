@@ -0,0 +1,220 @@
+#pragma once
+#include "BoundingBox.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8508 {
+		/*
+		Sort and sweep broadphase. Keeps the min and max endpoints of every box
+		along one axis in a sorted array that persists between frames. Objects
+		only move a little each step, so re-sorting with an insertion sort is
+		close to linear. The sweep then only has to test the boxes that overlap
+		along the sorted axis against each other.
+
+		There's no fixed world size - any box anywhere can be inserted.
+		*/
+		template<class T>
+		class SweepAndPrune {
+		public:
+			static const int NullProxy = -1;
+
+			SweepAndPrune(int axis = 0) {
+				this->axis		= axis;
+				freeList		= NullProxy;
+				needsFullSort	= false;
+				pendingInserts	= 0;
+			}
+			~SweepAndPrune() {
+			}
+
+			void Clear() {
+				proxies.clear();
+				endpoints.clear();
+				active.clear();
+				freeList		= NullProxy;
+				needsFullSort	= false;
+				pendingInserts	= 0;
+			}
+
+			int Insert(T object, const BoundingBox& bounds) {
+				int id;
+				if (freeList == NullProxy) {
+					id = (int)proxies.size();
+					proxies.emplace_back();
+				}
+				else {
+					id = freeList;
+					freeList = proxies[id].nextFree;
+				}
+				proxies[id].object		= object;
+				proxies[id].bounds		= bounds;
+				proxies[id].nextFree	= NullProxy;
+				proxies[id].inUse		= true;
+
+				//Appended unsorted, the next Sort will put them in place
+				endpoints.push_back({ bounds.min[axis], id * 2 });
+				endpoints.push_back({ bounds.max[axis], id * 2 + 1 });
+				pendingInserts++;
+				return id;
+			}
+
+			void Remove(int proxy) {
+				endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+					[&](const Endpoint& e) { return e.GetProxy() == proxy; }), endpoints.end());
+
+				proxies[proxy].inUse	= false;
+				proxies[proxy].object	= T();
+				proxies[proxy].nextFree = freeList;
+				freeList = proxy;
+			}
+
+			void Update(int proxy, const BoundingBox& bounds) {
+				proxies[proxy].bounds = bounds;
+			}
+
+			const BoundingBox& GetBounds(int proxy) const {
+				return proxies[proxy].bounds;
+			}
+
+			int GetAxis() const {
+				return axis;
+			}
+
+			void SetAxis(int newAxis) {
+				if (newAxis != axis) {
+					axis = newAxis;
+					needsFullSort = true;
+				}
+			}
+
+			/*
+			Picks whichever axis the objects are most spread out along, as that's
+			the one that separates the most pairs.
+			*/
+			void SelectDominantAxis() {
+				Vector3 sum;
+				Vector3 sumSq;
+				int count = 0;
+				for (const Proxy& p : proxies) {
+					if (!p.inUse) {
+						continue;
+					}
+					Vector3 c = p.bounds.GetCentre();
+					sum		+= c;
+					sumSq	+= c * c;
+					count++;
+				}
+				if (count == 0) {
+					return;
+				}
+				Vector3 variance = (sumSq / (float)count) - ((sum / (float)count) * (sum / (float)count));
+
+				int best = 0;
+				for (int i = 1; i < 3; ++i) {
+					if (variance[i] > variance[best]) {
+						best = i;
+					}
+				}
+				SetAxis(best);
+			}
+
+			/*
+			Pulls the latest box positions into the endpoint array and restores its
+			order. Insertion sort is used when the array is already mostly sorted,
+			falling back to a full sort after a change of axis or lots of inserts.
+			*/
+			void Sort() {
+				for (Endpoint& e : endpoints) {
+					const BoundingBox& b = proxies[e.GetProxy()].bounds;
+					e.value = e.IsMax() ? b.max[axis] : b.min[axis];
+				}
+				if (needsFullSort || pendingInserts > MaxIncrementalInserts) {
+					std::sort(endpoints.begin(), endpoints.end());
+				}
+				else {
+					for (size_t i = 1; i < endpoints.size(); ++i) {
+						Endpoint e = endpoints[i];
+						size_t j = i;
+						while (j > 0 && e < endpoints[j - 1]) {
+							endpoints[j] = endpoints[j - 1];
+							--j;
+						}
+						endpoints[j] = e;
+					}
+				}
+				needsFullSort	= false;
+				pendingInserts	= 0;
+			}
+
+			/*
+			Calls func(a, b) once for every pair of boxes that overlap. Expects
+			Sort to have been called since the last round of updates.
+			*/
+			template <typename F>
+			void FindPairs(F&& func) {
+				active.clear();
+				for (const Endpoint& e : endpoints) {
+					int id = e.GetProxy();
+					if (e.IsMax()) {
+						for (size_t i = 0; i < active.size(); ++i) {
+							if (active[i] == id) {
+								active[i] = active.back();
+								active.pop_back();
+								break;
+							}
+						}
+						continue;
+					}
+					const Proxy& p = proxies[id];
+					for (int other : active) {
+						if (p.bounds.Overlaps(proxies[other].bounds)) {
+							func(p.object, proxies[other].object);
+						}
+					}
+					active.push_back(id);
+				}
+			}
+
+		protected:
+			static const int MaxIncrementalInserts = 32;
+
+			struct Endpoint {
+				float	value;
+				int		data; //Proxy index in the upper bits, 1 in the lowest bit for a max endpoint
+
+				int GetProxy() const {
+					return data >> 1;
+				}
+				bool IsMax() const {
+					return (data & 1) != 0;
+				}
+				//Mins sort before maxes at the same value, so touching boxes still overlap
+				bool operator < (const Endpoint& other) const {
+					if (value != other.value) {
+						return value < other.value;
+					}
+					if (IsMax() != other.IsMax()) {
+						return !IsMax();
+					}
+					return GetProxy() < other.GetProxy();
+				}
+			};
+
+			struct Proxy {
+				BoundingBox bounds;
+				T		object = T();
+				int		nextFree = NullProxy;
+				bool	inUse = false;
+			};
+
+			std::vector<Proxy>		proxies;
+			std::vector<Endpoint>	endpoints;
+			std::vector<int>		active;
+
+			int		axis;
+			int		freeList;
+			int		pendingInserts;
+			bool	needsFullSort;
+		};
+	}
+}
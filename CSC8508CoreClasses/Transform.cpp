@@ -1,36 +1,135 @@
 #include "Transform.h"
+#include <algorithm>
 
 using namespace NCL::CSC8508;
 
+float Transform::renderInterpolation = 1.0f;
+unsigned int Transform::updatePass = 0;
+unsigned int Transform::hierarchyVersion = 0;
+
 Transform::Transform()	{
-	scale = Vector3(1, 1, 1);
+	scale			= Vector3(1, 1, 1);
+	interpolating	= false;
+	blended			= false;
+	parent			= nullptr;
+	depth			= 0;
+	dirty			= true;
+	updatedPass		= 0;
 }
 
+//Children outlive their parent as roots, rather than pointing at nothing
 Transform::~Transform()	{
+	SetParent(nullptr);
+	while (!children.empty()) {
+		children.back()->SetParent(nullptr);
+	}
+}
 
+void Transform::SetParent(Transform* newParent) {
+	if (newParent == parent) {
+		return;
+	}
+	for (Transform* t = newParent; t; t = t->parent) {
+		if (t == this) {
+			return;
+		}
+	}
+	if (parent) {
+		parent->children.erase(std::remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
+	}
+	parent = newParent;
+	if (parent) {
+		parent->children.push_back(this);
+	}
+	SetDepth(parent ? parent->depth + 1 : 0);
+	dirty = true;
+	hierarchyVersion++;
 }
 
+void Transform::SetDepth(int newDepth) {
+	depth = newDepth;
+	for (Transform* child : children) {
+		child->SetDepth(newDepth + 1);
+	}
+}
+
+/*
+A transform is rebuilt if it was changed itself, if its parent was rebuilt
+earlier in the same pass - parents always come first, as the pass goes through
+the transforms in order of depth - or if it's being blended, or just stopped
+being. The render matrix is built from the parent's render matrix, so nothing
+reading it has to walk up the hierarchy.
+*/
 void Transform::UpdateMatrix() {
-	matrix =
-		Matrix::Translation(position) *
-		Quaternion::RotationMatrix<Matrix4>(orientation) *
+	bool parentUpdated	= parent && parent->updatedPass == updatePass;
+	bool blending		= interpolating && renderInterpolation < 1.0f;
+	if (!dirty && !parentUpdated && !blending && !blended) {
+		return;
+	}
+	if (dirty) {
+		localMatrix =
+			Matrix::Translation(position) *
+			Quaternion::RotationMatrix<Matrix4>(orientation) *
+			Matrix::Scale(scale);
+	}
+	worldMatrix = parent ? parent->worldMatrix * localMatrix : localMatrix;
+
+	Matrix4 renderLocal = blending ? GetInterpolatedMatrix() : localMatrix;
+	renderMatrix = parent ? parent->renderMatrix * renderLocal : renderLocal;
+
+	blended		= blending;
+	dirty		= false;
+	updatedPass = updatePass;
+}
+
+Matrix4 Transform::GetInterpolatedMatrix() const {
+	Vector3		blendedPosition		= previousPosition + (position - previousPosition) * renderInterpolation;
+	Quaternion	blendedOrientation	= Quaternion::Slerp(previousOrientation, orientation, renderInterpolation);
+	return
+		Matrix::Translation(blendedPosition) *
+		Quaternion::RotationMatrix<Matrix4>(blendedOrientation) *
 		Matrix::Scale(scale);
 }
 
+//Anything moved outside of the physics step is moved there straight away
 Transform& Transform::SetPosition(const Vector3& worldPos) {
+	interpolating = false;
 	position = worldPos;
-	UpdateMatrix();
+	dirty = true;
 	return *this;
 }
 
 Transform& Transform::SetScale(const Vector3& worldScale) {
 	scale = worldScale;
-	UpdateMatrix();
+	dirty = true;
 	return *this;
 }
 
 Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
+	interpolating = false;
 	orientation = worldOrientation;
-	UpdateMatrix();
+	dirty = true;
 	return *this;
+}
+
+Transform& Transform::SetPositionAndOrientation(const Vector3& worldPos, const Quaternion& worldOrientation) {
+	interpolating = false;
+	position	= worldPos;
+	orientation = worldOrientation;
+	dirty = true;
+	return *this;
+}
+
+Transform& Transform::StepTo(const Vector3& worldPos, const Quaternion& worldOrientation) {
+	previousPosition	= position;
+	previousOrientation	= orientation;
+	interpolating		= true;
+	position			= worldPos;
+	orientation			= worldOrientation;
+	dirty = true;
+	return *this;
+}
+
+void Transform::StopInterpolating() {
+	interpolating = false;
 }
\ No newline at end of file
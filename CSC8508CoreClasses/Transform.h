@@ -6,15 +6,53 @@ using namespace NCL::Maths;
 
 namespace NCL {
 	namespace CSC8508 {
+		/*
+		Position, orientation and scale are kept relative to the parent, if there
+		is one, and are the world values otherwise. Setting them only marks the
+		transform as dirty - the matrices are rebuilt once a frame, for every dirty
+		transform at once, by GameWorld::UpdateTransforms, which also carries any
+		change down to the children, and blends anything the physics steps have
+		moved for rendering. Physics works in world space, so anything
+		with a physics object should be left without a parent.
+		*/
 		class Transform
 		{
 		public:
 			Transform();
 			~Transform();
 
+			//Parent and child links point at the transforms themselves, so a copy would leave them pointing at the wrong one
+			Transform(const Transform&) = delete;
+			Transform& operator=(const Transform&) = delete;
+
+			/*
+			Children keep their local values, so they move with the new parent.
+			Parenting to this transform or one of its own children would make a
+			loop, so is ignored.
+			*/
+			void SetParent(Transform* newParent);
+
+			Transform* GetParent() const {
+				return parent;
+			}
+
+			const vector<Transform*>& GetChildren() const {
+				return children;
+			}
+
+			//How many parents are above this one
+			int GetDepth() const {
+				return depth;
+			}
+
 			Transform& SetPosition(const Vector3& worldPos);
 			Transform& SetScale(const Vector3& worldScale);
 			Transform& SetOrientation(const Quaternion& newOr);
+			Transform& SetPositionAndOrientation(const Vector3& worldPos, const Quaternion& newOr);
+
+			//Moves on by a physics step, keeping where it was so rendering can blend between the two
+			Transform& StepTo(const Vector3& worldPos, const Quaternion& newOr);
+			void StopInterpolating();
 
 			Vector3 GetPosition() const {
 				return position;
@@ -28,16 +66,78 @@ namespace NCL {
 				return orientation;
 			}
 
-			Matrix4 GetMatrix() const {
-				return matrix;
+			//As of the last UpdateTransforms, and blended between the last two physics steps, so use this for rendering only
+			const Matrix4& GetMatrix() const {
+				return renderMatrix;
+			}
+
+			//As of the last UpdateTransforms, and not blended
+			Matrix4 GetWorldMatrix() const {
+				return worldMatrix;
+			}
+
+			Vector3 GetWorldPosition() const {
+				return Vector3(worldMatrix.GetColumn(3));
+			}
+
+			bool IsDirty() const {
+				return dirty;
 			}
+
+			/*
+			Rebuilds the matrices now, if anything has changed, assuming the
+			parent's are already up to date. Transforms being blended between
+			physics steps are rebuilt every time, as the blend moves on each frame.
+			*/
 			void UpdateMatrix();
+
+			/*
+			Starts a new pass over the transforms, so a child can tell whether its
+			parent was updated in the same pass.
+			*/
+			static void BeginUpdatePass() {
+				updatePass++;
+			}
+
+			//Changes whenever any transform changes parent
+			static unsigned int GetHierarchyVersion() {
+				return hierarchyVersion;
+			}
+
+			//How far between the last two physics steps rendering should be, from 0 to 1
+			static void SetRenderInterpolation(float alpha) {
+				renderInterpolation = alpha;
+			}
+
+			static float GetRenderInterpolation() {
+				return renderInterpolation;
+			}
 		protected:
-			Matrix4		matrix;
+			Matrix4 GetInterpolatedMatrix() const;
+			void SetDepth(int newDepth);
+
+			Matrix4		localMatrix;
+			Matrix4		worldMatrix;
+			Matrix4		renderMatrix;
 			Quaternion	orientation;
 			Vector3		position;
 
 			Vector3		scale;
+
+			Quaternion	previousOrientation;
+			Vector3		previousPosition;
+			bool		interpolating;
+			bool		blended; //If the render matrix was last built from a blend
+
+			Transform*			parent;
+			vector<Transform*>	children;
+			int					depth;
+			bool				dirty;
+			unsigned int		updatedPass;
+
+			static float renderInterpolation;
+			static unsigned int updatePass;
+			static unsigned int hierarchyVersion;
 		};
 	}
 }
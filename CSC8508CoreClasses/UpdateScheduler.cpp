@@ -0,0 +1,87 @@
+#include "UpdateScheduler.h"
+#include "GameObject.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8508;
+
+UpdateScheduler::UpdateScheduler() {
+}
+
+UpdateScheduler::~UpdateScheduler() {
+}
+
+void UpdateScheduler::AddSystem(UpdatePhases::Phase phase, SystemFunc system) {
+	systems[phase].emplace_back(std::move(system));
+}
+
+UpdateScheduler::TypeList& UpdateScheduler::GetTypeList(UpdatePhases::Phase phase, ComponentTypeID type) {
+	for (TypeList& list : componentLists[phase]) {
+		if (list.type == type) {
+			return list;
+		}
+	}
+	componentLists[phase].push_back(TypeList{ type, {} });
+	return componentLists[phase].back();
+}
+
+void UpdateScheduler::AddComponent(IComponent* component, ComponentTypeID type, UpdatePhases::PhaseMask phases) {
+	for (int i = 0; i < UpdatePhases::PhaseCount; ++i) {
+		if (phases & (1u << i)) {
+			GetTypeList((UpdatePhases::Phase)i, type).components.push_back(component);
+		}
+	}
+}
+
+void UpdateScheduler::RemoveComponent(IComponent* component, ComponentTypeID type, UpdatePhases::PhaseMask phases) {
+	for (int i = 0; i < UpdatePhases::PhaseCount; ++i) {
+		if (phases & (1u << i)) {
+			TypeList& list = GetTypeList((UpdatePhases::Phase)i, type);
+			auto slot = std::find(list.components.begin(), list.components.end(), component);
+			if (slot != list.components.end()) {
+				*slot = nullptr;
+				list.removedCount++;
+			}
+		}
+	}
+}
+
+void UpdateScheduler::ClearComponents() {
+	for (std::vector<TypeList>& lists : componentLists) {
+		lists.clear();
+	}
+}
+
+/*
+Components may remove objects from the world, or add new ones, as they update.
+Removing only clears a component's slot, so nothing in a list moves while it's
+being walked, and the gaps are closed up before the phase next runs. Added
+components go on the end, and the lists are walked by index, their sizes
+checked every time round, so they're still reached this phase.
+*/
+void UpdateScheduler::RunPhase(UpdatePhases::Phase phase, float dt) {
+	std::vector<TypeList>& lists = componentLists[phase];
+	for (TypeList& list : lists) {
+		if (list.removedCount > 0) {
+			list.components.erase(std::remove(list.components.begin(), list.components.end(), nullptr), list.components.end());
+			list.removedCount = 0;
+		}
+	}
+	for (size_t l = 0; l < lists.size(); ++l) {
+		for (size_t i = 0; i < lists[l].components.size(); ++i) {
+			IComponent* c = lists[l].components[i];
+			if (c && c->IsEnabled() && c->GetGameObject().IsEnabled()) {
+				c->InvokePhase(phase, dt);
+			}
+		}
+	}
+	for (size_t i = 0; i < systems[phase].size(); ++i) {
+		systems[phase][i](dt);
+	}
+}
+
+void UpdateScheduler::Update(float dt) {
+	for (int i = 0; i < UpdatePhases::PhaseCount; ++i) {
+		RunPhase((UpdatePhases::Phase)i, dt);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "IComponent.h"
+
+namespace NCL {
+	namespace CSC8508 {
+		/*
+		Runs a frame as a fixed series of phases - PreUpdate, Update, PhysicsStep,
+		LateUpdate and PreRender. Each phase first runs the components that
+		override its hook, then the systems added to it, in the order they were
+		added.
+
+		Components are only added to the lists of the phases they override a hook
+		for, so a component, or an object, with nothing to do each frame is never
+		visited. The lists are kept per component type, so a phase runs through
+		every component of one type before moving on to the next, calling the same
+		code over and over rather than jumping between types.
+		*/
+		class UpdateScheduler {
+		public:
+			typedef std::function<void(float)> SystemFunc;
+
+			UpdateScheduler();
+			~UpdateScheduler();
+
+			void AddSystem(UpdatePhases::Phase phase, SystemFunc system);
+
+			void AddComponent(IComponent* component, ComponentTypeID type, UpdatePhases::PhaseMask phases);
+			void RemoveComponent(IComponent* component, ComponentTypeID type, UpdatePhases::PhaseMask phases);
+
+			//Drops every component, but keeps the systems
+			void ClearComponents();
+
+			void RunPhase(UpdatePhases::Phase phase, float dt);
+
+			//Runs every phase, in order
+			void Update(float dt);
+
+		protected:
+			//Removed components leave a null behind, until the list's phase next starts
+			struct TypeList {
+				ComponentTypeID				type;
+				std::vector<IComponent*>	components;
+				int							removedCount = 0;
+			};
+
+			TypeList& GetTypeList(UpdatePhases::Phase phase, ComponentTypeID type);
+
+			std::vector<TypeList>	componentLists[UpdatePhases::PhaseCount];
+			std::vector<SystemFunc>	systems[UpdatePhases::PhaseCount];
+		};
+	}
+}